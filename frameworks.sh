@@ -1,14 +1,18 @@
 #!/bin/bash
 PROJ_DIR=./frameworks
-IMPLEMENTATION="pps pps-c17 pps-tbb"
+BACKENDS="omp c17 tbb pool"
 MIN=2
 MAX=2048
 export LD_LIBRARY_PATH=$PROJ_DIR
+# generate the regions if they are missing
+if [ ! -f data/1k1.hex ]; then
+	make -C generator && mkdir -p data && generator/regionGen 1000 data/1k1.hex data/1k2.hex
+fi
 for i in {1..100}
 do	
-	for IMPL in $IMPLEMENTATION
+	for BACKEND in $BACKENDS
 	do
-		echo "Iteration $i $IMPL"
-		"$PROJ_DIR"/"$IMPL" "$PROJ_DIR"/../data/1k1.hex "$PROJ_DIR"/../data/1k2.hex "$MIN" "$MAX";
+		echo "Iteration $i $BACKEND"
+		PPS_BACKEND="$BACKEND" "$PROJ_DIR"/pps "$PROJ_DIR"/../data/1k1.hex "$PROJ_DIR"/../data/1k2.hex "$MIN" "$MAX";
 	done;
 done;
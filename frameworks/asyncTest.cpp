@@ -0,0 +1,70 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+#include <iostream>
+#include <vector>
+#include <future>
+#include <chrono>
+#include "parPlaneSweep.h"
+#include "executor.h"
+#include "generatedRegions.h"
+using namespace std;
+
+/**
+ * Checks that a small overlay started with parallelOverlayAsync() does not wait for a big one
+ * started next to it.  A large overlay is started in the middle of many small ones on the pool 
+ * backend, and every small future must be ready while the large one is still running.  A thread
+ * waiting for a small overlay's loop picks up the large overlay only now and then, when the 
+ * large one is the oldest task it can steal, so each thread count is run a few rounds.
+ *
+ * Prints the failures and exits with 1 if there is any, 0 otherwise.
+ */
+int main( int argc, char * argv[] ) 
+{
+    const int numSmall = 16;
+    const int smallStrips = 32;
+    const int rounds = 5;
+    const int threadCounts[] = { 2, 4 };
+    genOptions largeOpts, smallOpts;
+    largeOpts.segments = 100000;
+    smallOpts.segments = 2000;
+    vector< halfsegment > l1, l2, s1, s2;
+    generateInputs( largeOpts, l1, l2 );
+    generateInputs( smallOpts, s1, s2 );
+    int checked = 0, failed = 0;
+    for( int run = 0; run < 2 * rounds; run++ ) {
+        int threads = threadCounts[run / rounds];
+        OverlayContext context( threads, BACKEND_POOL );
+        vector< halfsegment > largeResult;
+        vector< vector< halfsegment > > smallResults( numSmall );
+        vector< future<void> > small;
+        future<void> large;
+        for( int i = 0; i < numSmall; i++ ) {
+            if( i == numSmall / 2 ) {
+                large = parallelOverlayAsync( context, l1, l2, largeResult );
+            }
+            small.push_back( parallelOverlayAsync( context, s1, s2, smallResults[i], smallStrips ) );
+        }
+        for( int i = 0; i < numSmall; i++ ) {
+            small[i].get();
+        }
+        checked++;
+        if( large.wait_for( chrono::seconds( 0 ) ) == future_status::ready ) {
+            failed++;
+            cout << "the large overlay finished before the small ones, " << threads 
+                 << " threads, round " << run % rounds << endl;
+        }
+        large.get();
+    }
+    cout << "asyncTest: " << checked - failed << " of " << checked << " runs finish the small overlays first" << endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <thread>
+#include "parPlaneSweep.h"
+#include "executor.h"
+#include "regionFile.h"
+#include <fstream>
+using namespace std;
+
+/**
+ * One cell of the benchmark matrix: an implementation at a strip count and thread count, and
+ * its timings
+ */
+struct benchConfig {
+    string impl;             ///< serial, or the backend's name
+    overlayBackend backend;  ///< the backend, unused for serial
+    int strips;              ///< the number of strips, 1 for serial
+    int threads;             ///< the number of threads
+    OverlayContext* context; ///< shared by all configs with the same backend and threads, NULL for serial
+    vector< double > times;  ///< wall time of each timed run in seconds
+    long long resultSegs;    ///< halfsegments in the result of the last run
+};
+
+/**
+ * A median and its 95% confidence interval
+ */
+struct medianCI {
+    double median, low, high;
+};
+
+/**
+ * Parse a comma separated list of ints
+ * @param [in] list: the list, for example 2,16,64
+ * @param [out] values: the parsed values
+ */
+void parseIntList( const string& list, vector< int >& values )
+{
+    vector< string > tokens;
+    tokenizeString( list, tokens, "," );
+    values.clear();
+    for( int i = 0; i < tokens.size(); i++ ) {
+        values.push_back( atoi( tokens[i].c_str() ) );
+    }
+}
+
+/**
+ * The median of a sample, with a distribution free 95% confidence interval from the order
+ * statistics.  With fewer than 6 samples the interval is the whole range.
+ * @param [in] sample: the timings
+ */
+medianCI computeMedianCI( vector< double > sample )
+{
+    medianCI ci;
+    std::sort( sample.begin(), sample.end() );
+    int n = sample.size();
+    ci.median = ( n % 2 ) ? sample[n/2] : ( sample[n/2-1] + sample[n/2] ) / 2;
+    // ranks (1 based) n/2 -+ 1.96 sqrt(n)/2, normal approximation of the binomial
+    int lowRank = (int) floor( ( n - 1.96 * sqrt( (double) n ) ) / 2 );
+    int highRank = (int) ceil( 1 + ( n + 1.96 * sqrt( (double) n ) ) / 2 );
+    ci.low = sample[ std::max( lowRank, 1 ) - 1 ];
+    ci.high = sample[ std::min( highRank, n ) - 1 ];
+    return ci;
+}
+
+/**
+ * Run one config once
+ * @param [in] config: what to run
+ * @param [in] v1, v2: the sorted regions
+ * @param [out] result: the overlay
+ * @return the wall time in seconds
+ */
+double runOnce( benchConfig& config, vector< halfsegment >& v1, vector< halfsegment >& v2, 
+                vector< halfsegment >& result )
+{
+    std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+    if( config.context == NULL ) {
+        result.clear();
+        overlayPlaneSweep( &(v1[0]), v1.size(), &(v2[0]), v2.size(), result );
+    }
+    else {
+        parallelOverlay( *config.context, v1, v2, result, config.strips );
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    config.resultSegs = result.size();
+    return elapsed.count();
+}
+
+/**
+ * Runs every backend at every strip count and thread count, plus the serial plane sweep, in one
+ * process.  The inputs are read and sorted once and each backend's threads are started once.
+ * After the warm up runs, each round runs every config once in a new random order, so drift 
+ * in the machine's state spreads over all configs.  Prints the median time of each config with
+ * its 95% confidence interval, and its speedup over the serial plane sweep.
+ *
+ * The command line arguments required are:
+ *  - [an input hex file with region 1]
+ *  - [an input hex file with region 2]
+ *
+ * Optional arguments, in any order after those:
+ *  - -b [backends]: comma separated omp, tbb, c17 and pool (default all of them)
+ *  - -s [strip counts]: comma separated (default 2,8,32,128)
+ *  - -t [thread counts]: comma separated (default powers of two up to the number of cpus).  
+ *    The c17 backend can not set its thread count and runs once with the library's default
+ *  - -r [timed rounds] (default 10)
+ *  - -w [warm up rounds] (default 2)
+ *  - -seed [seed for the run order] (default 1)
+ *  - -o [csv file]: also append one row per config to this file
+ */
+int main( int argc, char * argv[] )
+{
+    if( argc < 3 || ( argc - 3 ) % 2 != 0 )
+    {
+        std::cerr << "usage: benchRunner [input file name 1] [input file name 2] [-b backends] [-s strips] [-t threads] [-r rounds] [-w warmups] [-seed seed] [-o csv]" << std::endl;
+        exit( -1 );
+    }
+    vector< string > backendNames;
+    tokenizeString( "omp,tbb,c17,pool", backendNames, "," );
+    vector< int > stripCounts, threadCounts;
+    parseIntList( "2,8,32,128", stripCounts );
+    int numCpus = std::max( 1u, std::thread::hardware_concurrency() );
+    for( int t = 1; t < numCpus; t *= 2 ) {
+        threadCounts.push_back( t );
+    }
+    threadCounts.push_back( numCpus );
+    int rounds = 10, warmups = 2;
+    unsigned int seed = 1;
+    string csvFileName;
+    for( int i = 3; i < argc; i += 2 ) {
+        string flag( argv[i] );
+        string value( argv[i+1] );
+        if( flag == "-b" ) {
+            backendNames.clear();
+            tokenizeString( value, backendNames, "," );
+        }
+        else if( flag == "-s" ) parseIntList( value, stripCounts );
+        else if( flag == "-t" ) parseIntList( value, threadCounts );
+        else if( flag == "-r" ) rounds = atoi( value.c_str() );
+        else if( flag == "-w" ) warmups = atoi( value.c_str() );
+        else if( flag == "-seed" ) seed = atoi( value.c_str() );
+        else if( flag == "-o" ) csvFileName = value;
+        else {
+            std::cerr << "unknown option: " << flag << std::endl;
+            exit( -1 );
+        }
+    }
+    if( rounds < 1 ) {
+        rounds = 1;
+    }
+
+    // read and sort the inputs once
+    vector< halfsegment > v1, v2, result;
+    if( !readHexRegion( argv[1], 2, v1 ) || !readHexRegion( argv[2], 3, v2 ) )
+    {
+        cerr << "Error: could not open file: " << argv[1] << " or " << argv[2] << endl;
+        exit( -1 );
+    }
+    std::sort( v1.begin(), v1.end() );
+    std::sort( v2.begin(), v2.end() );
+
+    // the matrix.  The serial plane sweep comes first, it is the baseline for the speedups
+    vector< benchConfig > configs;
+    vector< OverlayContext* > contexts;
+    benchConfig serial;
+    serial.impl = "serial";
+    serial.backend = BACKEND_DEFAULT;
+    serial.strips = 1;
+    serial.threads = 1;
+    serial.context = NULL;
+    configs.push_back( serial );
+    for( int b = 0; b < backendNames.size(); b++ ) {
+        overlayBackend backend = backendFromName( backendNames[b] );
+        if( backend == BACKEND_DEFAULT ) {
+            cerr << "unknown backend: " << backendNames[b] << ", use omp, tbb, c17 or pool" << endl;
+            exit( -1 );
+        }
+        vector< int > threads = threadCounts;
+        if( backend == BACKEND_C17 ) {
+            threads.assign( 1, -1 );
+        }
+        for( int t = 0; t < threads.size(); t++ ) {
+            contexts.push_back( new OverlayContext( threads[t], backend ) );
+            for( int s = 0; s < stripCounts.size(); s++ ) {
+                benchConfig config;
+                config.impl = backendNames[b];
+                config.backend = backend;
+                config.strips = stripCounts[s];
+                config.threads = contexts.back()->concurrency();
+                config.context = contexts.back();
+                configs.push_back( config );
+            }
+        }
+    }
+
+    // warm up, then time the rounds, each in a new random order
+    std::mt19937 gen( seed );
+    vector< int > order( configs.size() );
+    for( int i = 0; i < order.size(); i++ ) {
+        order[i] = i;
+    }
+    for( int round = 0; round < warmups + rounds; round++ ) {
+        cerr << ( round < warmups ? "warm up " : "round " ) << ( round < warmups ? round : round - warmups ) + 1 << endl;
+        std::shuffle( order.begin(), order.end(), gen );
+        for( int i = 0; i < order.size(); i++ ) {
+            benchConfig& config = configs[ order[i] ];
+            double seconds = runOnce( config, v1, v2, result );
+            if( round >= warmups ) {
+                config.times.push_back( seconds );
+            }
+        }
+    }
+
+    // report
+    medianCI base = computeMedianCI( configs[0].times );
+    std::ofstream csv;
+    if( !csvFileName.empty() ) {
+        csv.open( csvFileName.c_str(), std::ofstream::out | std::ofstream::app );
+    }
+    cout << std::left << std::setw( 8 ) << "impl" << std::right << std::setw( 8 ) << "threads" 
+         << std::setw( 8 ) << "strips" << std::setw( 12 ) << "median ms" << std::setw( 24 ) << "95% CI ms"
+         << std::setw( 10 ) << "speedup" << std::setw( 20 ) << "95% CI" << endl;
+    for( int i = 0; i < configs.size(); i++ ) {
+        const benchConfig& config = configs[i];
+        medianCI ci = computeMedianCI( config.times );
+        // conservative interval of the ratio of the two medians
+        double speedup = base.median / ci.median;
+        double speedupLow = base.low / ci.high;
+        double speedupHigh = base.high / ci.low;
+        cout << std::left << std::setw( 8 ) << config.impl << std::right << std::setw( 8 ) << config.threads
+             << std::setw( 8 ) << config.strips << std::fixed << std::setprecision( 3 )
+             << std::setw( 12 ) << ci.median * 1000 
+             << std::setw( 12 ) << ci.low * 1000 << std::setw( 12 ) << ci.high * 1000
+             << std::setprecision( 2 ) << std::setw( 10 ) << speedup 
+             << std::setw( 10 ) << speedupLow << std::setw( 10 ) << speedupHigh;
+        if( config.resultSegs != configs[0].resultSegs ) {
+            cout << "  result has " << config.resultSegs << " halfsegments, serial has " << configs[0].resultSegs;
+        }
+        cout << endl;
+        if( csv.is_open() ) {
+            csv << config.impl << "," << config.threads << "," << config.strips << "," << config.times.size() << ","
+                << ci.median << "," << ci.low << "," << ci.high << "," 
+                << speedup << "," << speedupLow << "," << speedupHigh << endl;
+        }
+    }
+    for( int i = 0; i < contexts.size(); i++ ) {
+        delete contexts[i];
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+#include "executor.h"
+#include <numeric>
+#include <algorithm>
+#include <execution>
+#include <thread>
+
+/**
+ * \class c17Executor
+ *
+ * \brief C++17 parallel algorithms backend (std::for_each with std::execution::par).
+ *
+ * The standard library picks and owns the threads.  numWorkerThreads only sets the default
+ * number of strips, and the threads can not be pinned.
+ */
+class c17Executor : public executor {
+public:
+	c17Executor( int numWorkerThreads ) : numThreads( numWorkerThreads ) 
+	{
+		if( numThreads < 1 ) {
+			numThreads = std::thread::hardware_concurrency();
+		}
+	}
+	const char * name( ) const {
+		return "c17";
+	}
+	unsigned int concurrency( ) const {
+		return numThreads;
+	}
+	bool stealsWork( ) const {
+		return false;
+	}
+	void parallelFor( int n, const function<void(int)> &body ) {
+		std::vector<int> track( n );
+		std::iota( track.begin(), track.end(), 0 );
+		std::for_each( std::execution::par, track.begin(), track.end(), [&] (int i) {
+			body( i );
+		});
+	}
+private:
+	int numThreads;
+};
+
+executor * createC17Executor( int numWorkerThreads, bool pinThreads )
+{
+	return new c17Executor( numWorkerThreads );
+}
@@ -0,0 +1,61 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+#include "executor.h"
+#include <omp.h>
+
+/**
+ * \class ompExecutor
+ *
+ * \brief OpenMP backend.  Loops are dynamically scheduled one iteration at a time.
+ *
+ * Nested loops run on the calling thread (OpenMP's default of one active level).
+ */
+class ompExecutor : public executor {
+public:
+	ompExecutor( int numWorkerThreads, bool pinThreads ) : numThreads( numWorkerThreads ) 
+	{
+		if( numThreads < 1 ) {
+			numThreads = omp_get_num_procs();
+		}
+		// the runtime keeps the team's threads alive between parallel regions of the same size, 
+		// so pinning them once holds for every later loop
+		if( pinThreads ) {
+#pragma omp parallel num_threads(numThreads)
+			pinThisThread( omp_get_thread_num() );
+		}
+	}
+	const char * name( ) const {
+		return "orig";
+	}
+	unsigned int concurrency( ) const {
+		return numThreads;
+	}
+	bool stealsWork( ) const {
+		return false;
+	}
+	int workerIndex( ) const {
+		return omp_get_thread_num();
+	}
+	void parallelFor( int n, const function<void(int)> &body ) {
+#pragma omp parallel for schedule(dynamic,1) num_threads(numThreads)
+		for( int i = 0; i < n; i++ ) {
+			body( i );
+		}
+	}
+private:
+	int numThreads;
+};
+
+executor * createOmpExecutor( int numWorkerThreads, bool pinThreads )
+{
+	return new ompExecutor( numWorkerThreads, pinThreads );
+}
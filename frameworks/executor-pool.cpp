@@ -0,0 +1,275 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+#include "executor.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <exception>
+
+/**
+ * \class poolExecutor
+ *
+ * \brief a work stealing thread pool.
+ *
+ * Every worker owns a deque of tasks.  A worker pushes the tasks it creates to the back of its
+ * own deque and takes its next task from the back as well, so it keeps working on the data it
+ * just touched.  An idle worker steals from the front of another worker's deque, where the 
+ * oldest (for strips, the biggest) tasks are.  A thread waiting for a loop runs queued tasks
+ * until the loop is finished, so loops nest without blocking a worker.  An exception thrown by
+ * a loop body is rethrown from parallelFor() once all of the loop's tasks are done.
+ *
+ * Every task belongs to a group: a task queued by async() starts a new group, and the tasks of
+ * a loop join the group of the thread that runs the loop.  A waiting thread only runs tasks of
+ * its own group.  It never picks up another overlay queued with async(), which would hold up 
+ * the loop it waits for until that other overlay is done.
+ */
+class poolExecutor : public executor {
+public:
+	poolExecutor( int numWorkerThreads, bool pinThreads );
+	~poolExecutor( );
+	const char * name( ) const {
+		return "pool";
+	}
+	unsigned int concurrency( ) const {
+		return workers.size();
+	}
+	bool stealsWork( ) const {
+		return true;
+	}
+	bool splitsHeavyStrips( ) const {
+		return true;
+	}
+	/// workers are numbered from 0, a thread outside the pool is -1
+	int workerIndex( ) const {
+		return workerID;
+	}
+	void parallelFor( int n, const function<void(int)> &body );
+	std::future<void> async( const function<void()> &task );
+
+private:
+	/// the tasks of one overlay
+	struct taskGroup {
+		/// tasks of the group sitting in a deque
+		atomic<int> queued;
+		taskGroup( ) : queued( 0 ) { }
+	};
+	struct poolTask {
+		function<void()> run;
+		std::shared_ptr< taskGroup > group;
+	};
+	struct workerQueue {
+		mutex lock;
+		deque< poolTask > tasks;
+	};
+
+	/// queue a task of a group.  A task queued from a worker goes to that worker's deque
+	void submit( const function<void()> &task, const std::shared_ptr< taskGroup > &group );
+	/**
+	 * pop a task from our own deque, or steal one, and run it.  Returns false if there was no task
+	 * \param group only run a task of this group, NULL runs any task
+	 */
+	bool runTask( int self, const taskGroup *group );
+	/// take the newest (fromBack) or oldest task of a group out of a deque
+	bool takeTask( workerQueue &q, bool fromBack, const taskGroup *group, poolTask &task );
+	void workerLoop( int self );
+
+	vector< workerQueue* > queues;
+	vector< thread > workers;
+	/// tasks sitting in a deque
+	atomic<int> queued;
+	/// round robin deque for tasks queued from outside the pool
+	atomic<unsigned int> nextQueue;
+	bool done;
+	bool pinThreads;
+	mutex sleepLock;
+	/// idle workers sleep here
+	condition_variable sleepCond;
+	/// threads waiting for a loop sleep here, until the loop is done or their group has a task
+	condition_variable waitCond;
+	/// the number of threads sleeping on waitCond
+	int waiting;
+	/// the worker running on this thread, -1 outside the pool
+	static thread_local int workerID;
+	/// the group of the task running on this thread, NULL outside a task
+	static thread_local std::shared_ptr< taskGroup > currentGroup;
+};
+
+thread_local int poolExecutor::workerID = -1;
+thread_local std::shared_ptr< poolExecutor::taskGroup > poolExecutor::currentGroup;
+
+poolExecutor::poolExecutor( int numWorkerThreads, bool pinThreads ) : 
+	queued( 0 ), nextQueue( 0 ), done( false ), pinThreads( pinThreads ), waiting( 0 )
+{
+	if( numWorkerThreads < 1 ) {
+		numWorkerThreads = std::max( 1u, std::thread::hardware_concurrency() );
+	}
+	for( int i = 0; i < numWorkerThreads; i++ ) {
+		queues.push_back( new workerQueue );
+	}
+	for( int i = 0; i < numWorkerThreads; i++ ) {
+		workers.push_back( thread( &poolExecutor::workerLoop, this, i ) );
+	}
+}
+
+poolExecutor::~poolExecutor( )
+{
+	{
+		lock_guard<mutex> guard( sleepLock );
+		done = true;
+	}
+	sleepCond.notify_all();
+	for( int i = 0; i < workers.size(); i++ ) {
+		workers[i].join();
+	}
+	for( int i = 0; i < queues.size(); i++ ) {
+		delete queues[i];
+	}
+}
+
+void poolExecutor::submit( const function<void()> &task, const std::shared_ptr< taskGroup > &group )
+{
+	int q = ( workerID >= 0 ) ? workerID : nextQueue++ % queues.size();
+	{
+		lock_guard<mutex> guard( queues[q]->lock );
+		queues[q]->tasks.push_back( poolTask{ task, group } );
+	}
+	bool wakeWaiters;
+	{
+		// count under the sleep lock so a thread going to sleep can not miss the task
+		lock_guard<mutex> guard( sleepLock );
+		queued++;
+		group->queued++;
+		wakeWaiters = waiting > 0;
+	}
+	sleepCond.notify_one();
+	if( wakeWaiters ) {
+		// only the waiters of the task's group can run it, and we do not know which those are
+		waitCond.notify_all();
+	}
+}
+
+bool poolExecutor::takeTask( workerQueue &q, bool fromBack, const taskGroup *group, poolTask &task )
+{
+	lock_guard<mutex> guard( q.lock );
+	for( int k = 0; k < q.tasks.size(); k++ ) {
+		int i = fromBack ? q.tasks.size() - 1 - k : k;
+		if( group == NULL || q.tasks[i].group.get() == group ) {
+			task = std::move( q.tasks[i] );
+			q.tasks.erase( q.tasks.begin() + i );
+			return true;
+		}
+	}
+	return false;
+}
+
+bool poolExecutor::runTask( int self, const taskGroup *group )
+{
+	poolTask task;
+	// newest task from our own deque, otherwise steal the oldest task of another worker
+	bool found = self >= 0 && takeTask( *queues[self], true, group, task );
+	for( int k = 1; !found && k <= queues.size(); k++ ) {
+		int victim = ( std::max( self, 0 ) + k ) % queues.size();
+		found = takeTask( *queues[victim], false, group, task );
+	}
+	if( !found ) {
+		return false;
+	}
+	queued--;
+	task.group->queued--;
+	std::shared_ptr< taskGroup > outer = currentGroup;
+	currentGroup = task.group;
+	task.run();
+	currentGroup = outer;
+	return true;
+}
+
+void poolExecutor::workerLoop( int self )
+{
+	workerID = self;
+	if( pinThreads ) {
+		pinThisThread( self );
+	}
+	while( true ) {
+		if( runTask( self, NULL ) ) {
+			continue;
+		}
+		unique_lock<mutex> guard( sleepLock );
+		sleepCond.wait( guard, [this] { return done || queued > 0; } );
+		if( done ) {
+			return;
+		}
+	}
+}
+
+void poolExecutor::parallelFor( int n, const function<void(int)> &body )
+{
+	// a loop run outside the pool's tasks starts a group of its own
+	std::shared_ptr< taskGroup > group = currentGroup ? currentGroup : std::make_shared< taskGroup >();
+	// the tasks point at these, so every task must be finished before they go out of scope
+	atomic<int> remaining( n );
+	mutex errorLock;
+	std::exception_ptr error;
+	for( int i = 0; i < n; i++ ) {
+		submit( [this, &body, &remaining, &errorLock, &error, i] { 
+			try {
+				body( i ); 
+			}
+			catch( ... ) {
+				lock_guard<mutex> guard( errorLock );
+				if( !error ) {
+					error = std::current_exception();
+				}
+			}
+			if( --remaining == 0 ) {
+				// under the sleep lock so the waiting thread can not miss it
+				lock_guard<mutex> guard( sleepLock );
+				waitCond.notify_all();
+			}
+		}, group );
+	}
+	// help out with our own group until the loop is finished, and sleep while it has no task queued
+	while( remaining > 0 ) {
+		if( !runTask( workerID, group.get() ) ) {
+			unique_lock<mutex> guard( sleepLock );
+			waiting++;
+			waitCond.wait( guard, [&remaining, &group] { return remaining == 0 || group->queued > 0; } );
+			waiting--;
+		}
+	}
+	if( error ) {
+		std::rethrow_exception( error );
+	}
+}
+
+std::future<void> poolExecutor::async( const function<void()> &task )
+{
+	std::shared_ptr< std::promise<void> > done( new std::promise<void> );
+	submit( [task, done] {
+		try {
+			task();
+			done->set_value();
+		}
+		catch( ... ) {
+			done->set_exception( std::current_exception() );
+		}
+	}, std::make_shared< taskGroup >() );
+	return done->get_future();
+}
+
+executor * createPoolExecutor( int numWorkerThreads, bool pinThreads )
+{
+	return new poolExecutor( numWorkerThreads, pinThreads );
+}
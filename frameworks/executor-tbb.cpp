@@ -0,0 +1,92 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+#include "executor.h"
+#include <tbb/tbb.h>
+#include <memory>
+
+/**
+ * \class slotPinner
+ *
+ * \brief pins every thread that joins an arena to the CPU of its slot in the arena.
+ */
+class slotPinner : public tbb::task_scheduler_observer {
+public:
+	slotPinner( tbb::task_arena &arena ) : tbb::task_scheduler_observer( arena ) { }
+	void on_scheduler_entry( bool worker ) {
+		pinThisThread( tbb::this_task_arena::current_thread_index() );
+	}
+};
+
+/**
+ * \class tbbExecutor
+ *
+ * \brief TBB backend.  Loops run in a task arena limited to the requested number of threads.
+ */
+class tbbExecutor : public executor {
+public:
+	tbbExecutor( int numWorkerThreads, bool pinThreads ) : 
+		arena( numWorkerThreads > 0 ? numWorkerThreads : int( tbb::task_arena::automatic ) ),
+		pinner( NULL )
+	{
+		arena.initialize();
+		if( pinThreads ) {
+			pinner = new slotPinner( arena );
+			pinner->observe( true );
+		}
+	}
+	~tbbExecutor( ) {
+		if( pinner != NULL ) {
+			pinner->observe( false );
+			delete pinner;
+		}
+	}
+	const char * name( ) const {
+		return "tbb";
+	}
+	unsigned int concurrency( ) const {
+		return arena.max_concurrency();
+	}
+	bool stealsWork( ) const {
+		return true;
+	}
+	int workerIndex( ) const {
+		return tbb::this_task_arena::current_thread_index();
+	}
+	void parallelFor( int n, const function<void(int)> &body ) {
+		arena.execute( [&] {
+			tbb::parallel_for( 0, n, [&] (int i) {
+				body( i );
+			});
+		});
+	}
+	std::future<void> async( const function<void()> &task ) {
+		std::shared_ptr< std::promise<void> > done( new std::promise<void> );
+		arena.enqueue( [task, done] {
+			try {
+				task();
+				done->set_value();
+			}
+			catch( ... ) {
+				done->set_exception( std::current_exception() );
+			}
+		});
+		return done->get_future();
+	}
+private:
+	tbb::task_arena arena;
+	slotPinner *pinner;
+};
+
+executor * createTbbExecutor( int numWorkerThreads, bool pinThreads )
+{
+	return new tbbExecutor( numWorkerThreads, pinThreads );
+}
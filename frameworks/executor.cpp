@@ -0,0 +1,221 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+#include "executor.h"
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <deque>
+#include <condition_variable>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+struct executor::asyncQueue {
+	std::deque< std::packaged_task<void()> > tasks;
+	condition_variable cond;
+	bool done;
+	thread runner;
+};
+
+executor::~executor( )
+{
+	if( asyncTasks == NULL ) {
+		return;
+	}
+	{
+		lock_guard<mutex> guard( asyncLock );
+		asyncTasks->done = true;
+	}
+	asyncTasks->cond.notify_one();
+	asyncTasks->runner.join();
+	delete asyncTasks;
+}
+
+std::future<void> executor::async( const function<void()> &task )
+{
+	std::packaged_task<void()> queued( task );
+	std::future<void> result = queued.get_future();
+	lock_guard<mutex> guard( asyncLock );
+	if( asyncTasks == NULL ) {
+		asyncTasks = new asyncQueue;
+		asyncTasks->done = false;
+		asyncTasks->runner = thread( [this] {
+			unique_lock<mutex> guard( asyncLock );
+			while( true ) {
+				asyncTasks->cond.wait( guard, [this] { return asyncTasks->done || !asyncTasks->tasks.empty(); } );
+				if( asyncTasks->tasks.empty() ) {
+					return;
+				}
+				std::packaged_task<void()> next = std::move( asyncTasks->tasks.front() );
+				asyncTasks->tasks.pop_front();
+				// the task runs parallel loops, so it must not hold the lock
+				guard.unlock();
+				next();
+				guard.lock();
+			}
+		});
+	}
+	asyncTasks->tasks.push_back( std::move( queued ) );
+	asyncTasks->cond.notify_one();
+	return result;
+}
+
+int executor::workerIndex( ) const
+{
+	static atomic<int> nextIndex( 0 );
+	static thread_local int index = nextIndex++;
+	return index;
+}
+
+overlayBackend backendFromName( const string &name )
+{
+	if( name == "omp" ) return BACKEND_OMP;
+	if( name == "tbb" ) return BACKEND_TBB;
+	if( name == "c17" ) return BACKEND_C17;
+	if( name == "pool" ) return BACKEND_POOL;
+	return BACKEND_DEFAULT;
+}
+
+executor * createExecutor( overlayBackend backend, int numWorkerThreads, bool pinThreads )
+{
+	if( backend == BACKEND_DEFAULT ) {
+		const char *env = getenv( "PPS_BACKEND" );
+		if( env != NULL ) {
+			backend = backendFromName( env );
+			if( backend == BACKEND_DEFAULT ) {
+				cerr << "unknown PPS_BACKEND " << env << ", using omp" << endl;
+			}
+		}
+	}
+	switch( backend ) {
+		case BACKEND_TBB:
+			return createTbbExecutor( numWorkerThreads, pinThreads );
+		case BACKEND_C17:
+			return createC17Executor( numWorkerThreads, pinThreads );
+		case BACKEND_POOL:
+			return createPoolExecutor( numWorkerThreads, pinThreads );
+		default:
+			return createOmpExecutor( numWorkerThreads, pinThreads );
+	}
+}
+
+bool pinThisThread( int slot )
+{
+#ifdef __linux__
+	cpu_set_t allowed;
+	if( sched_getaffinity( 0, sizeof( allowed ), &allowed ) != 0 || CPU_COUNT( &allowed ) == 0 ) {
+		return false;
+	}
+	// find the slot-th allowed cpu
+	slot %= CPU_COUNT( &allowed );
+	for( int cpu = 0; cpu < CPU_SETSIZE; cpu++ ) {
+		if( CPU_ISSET( cpu, &allowed ) && slot-- == 0 ) {
+			cpu_set_t pinned;
+			CPU_ZERO( &pinned );
+			CPU_SET( cpu, &pinned );
+			return sched_setaffinity( 0, sizeof( pinned ), &pinned ) == 0;
+		}
+	}
+#endif
+	return false;
+}
+
+int numaNodeCount( )
+{
+	// the online nodes, as a range list such as 0-1 or 0,2
+	ifstream online( "/sys/devices/system/node/online" );
+	string ranges;
+	if( !( online >> ranges ) ) {
+		return 1;
+	}
+	int count = 0;
+	stringstream ss( ranges );
+	string range;
+	while( getline( ss, range, ',' ) ) {
+		int lo = 0, hi = 0;
+		char dash;
+		stringstream rs( range );
+		rs >> lo;
+		if( rs >> dash >> hi ) {
+			count += hi - lo + 1;
+		}
+		else {
+			count++;
+		}
+	}
+	return std::max( count, 1 );
+}
+
+bool readNumaCounters( long long &localPages, long long &remotePages )
+{
+	localPages = remotePages = 0;
+	bool found = false;
+	for( int node = 0; ; node++ ) {
+		stringstream path;
+		path << "/sys/devices/system/node/node" << node << "/numastat";
+		ifstream stat( path.str().c_str() );
+		if( !stat ) {
+			// node numbers can have holes, but every machine has a node 0
+			if( node == 0 ) {
+				return false;
+			}
+			break;
+		}
+		string name;
+		long long pages;
+		while( stat >> name >> pages ) {
+			if( name == "local_node" ) {
+				localPages += pages;
+				found = true;
+			}
+			else if( name == "other_node" ) {
+				remotePages += pages;
+			}
+		}
+	}
+	return found;
+}
+
+OverlayContext::OverlayContext( int numWorkerThreads, overlayBackend backend, bool pinThreads )
+{
+	exec = createExecutor( backend, numWorkerThreads, pinThreads );
+	localStrips = pinThreads && numaNodeCount() > 1;
+	if( !readNumaCounters( startLocalPages, startRemotePages ) ) {
+		startLocalPages = startRemotePages = -1;
+	}
+}
+
+OverlayContext::~OverlayContext( )
+{
+	delete exec;
+}
+
+unsigned int OverlayContext::concurrency( ) const
+{
+	return exec->concurrency();
+}
+
+double OverlayContext::remoteAllocationRatio( ) const
+{
+	long long localPages, remotePages;
+	if( startLocalPages < 0 || !readNumaCounters( localPages, remotePages ) ) {
+		return -1;
+	}
+	localPages -= startLocalPages;
+	remotePages -= startRemotePages;
+	if( localPages + remotePages <= 0 ) {
+		return 0;
+	}
+	return double( remotePages ) / ( localPages + remotePages );
+}
@@ -0,0 +1,122 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+#include "parPlaneSweep.h"
+#include <functional>
+#include <future>
+#include <mutex>
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+/**
+ * \file
+ *
+ * The parallel backends parallelOverlay() runs on.  The overlay itself only ever asks an 
+ * executor to run a loop of independent iterations, so swapping the backend does not touch
+ * the algorithm.
+ */
+
+/**
+ * \class executor
+ *
+ * \brief runs the parallel loops of the overlay on one parallel framework.
+ *
+ * parallelFor() may be called from inside a loop body.  Backends that can not nest parallel 
+ * loops run the inner loop on the calling thread.
+ */
+class executor {
+public:
+	executor( ) : asyncTasks( NULL ) { }
+	/// a derived executor must outlive the tasks queued by the default async()
+	virtual ~executor( );
+
+	/// the label written to frameworks.csv for this backend
+	virtual const char * name( ) const = 0;
+
+	/// the number of threads the backend runs loops on
+	virtual unsigned int concurrency( ) const = 0;
+
+	/// true if idle threads steal queued iterations, so the iterations of nested loops keep every thread busy
+	virtual bool stealsWork( ) const = 0;
+
+	/**
+	 *  True if the overlay splits heavy strips into two loop iterations on this backend, see 
+	 *  sweepStrip().  Splitting changes the algorithm, so only a backend whose name labels 
+	 *  split runs does it, and the rows of the other backends stay comparable with older ones.
+	 */
+	virtual bool splitsHeavyStrips( ) const {
+		return false;
+	}
+
+	/**
+	 *  The index of the calling thread, for telemetry.  The default numbers threads in the 
+	 *  order they first ask, backends that number their own threads use those numbers.
+	 */
+	virtual int workerIndex( ) const;
+
+	/// run body(0) ... body(n-1) in parallel and wait for all of them
+	virtual void parallelFor( int n, const function<void(int)> &body ) = 0;
+
+	/**
+	 *  Run a task without waiting for it.  The default queues the task on one thread of the 
+	 *  executor's own, started by the first call, which runs the tasks one at a time in the order
+	 *  they were queued.  So a backend that runs each loop on a fixed team of threads (omp, c17)
+	 *  never runs more than one team.  Backends with a task queue (tbb, pool) override it and 
+	 *  run the tasks side by side on their own threads.
+	 */
+	virtual std::future<void> async( const function<void()> &task );
+
+private:
+	/// the thread and queue of the default async(), NULL until it is first called
+	struct asyncQueue;
+	asyncQueue *asyncTasks;
+	std::mutex asyncLock;
+};
+
+/**
+ *  Create the executor for a backend.  BACKEND_DEFAULT reads the PPS_BACKEND environment 
+ *  variable (omp, tbb, c17 or pool) and falls back to OpenMP.
+ *
+ *  \param numWorkerThreads the number of threads to use.  Values < 1 use the backend's default.
+ *  \param pinThreads pin the backend's threads to CPUs, see OverlayContext
+ *  \return a new executor, the caller deletes it
+ */
+executor * createExecutor( overlayBackend backend, int numWorkerThreads, bool pinThreads = false );
+
+/**
+ *  Parse a backend name: omp, tbb, c17 or pool.  Returns BACKEND_DEFAULT for anything else.
+ */
+overlayBackend backendFromName( const string &name );
+
+/**
+ *  Pin the calling thread to the slot-th CPU this process may run on, wrapping around if 
+ *  there are more slots than CPUs.  Returns false if the platform does not support it.
+ */
+bool pinThisThread( int slot );
+
+/**
+ *  The number of NUMA nodes on this machine, 1 if the platform does not tell.
+ */
+int numaNodeCount( );
+
+/**
+ *  Sum the pages allocated on the local node and on a remote node over all NUMA nodes, 
+ *  system wide, since boot.  Returns false if the platform does not expose the counters.
+ */
+bool readNumaCounters( long long &localPages, long long &remotePages );
+
+executor * createOmpExecutor( int numWorkerThreads, bool pinThreads );
+executor * createTbbExecutor( int numWorkerThreads, bool pinThreads );
+executor * createC17Executor( int numWorkerThreads, bool pinThreads );
+executor * createPoolExecutor( int numWorkerThreads, bool pinThreads );
+
+#endif
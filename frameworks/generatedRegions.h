@@ -0,0 +1,51 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+
+#include <vector>
+#include <algorithm>
+#include "halfsegment.h"
+#include "regionGen.h"
+
+#ifndef GENERATEDREGIONS_H
+#define GENERATEDREGIONS_H
+
+/**
+ * Generate a region pair in memory with the generator of regionGen, for the programs that 
+ * do not read their input from files.  Compile with -I ../generator
+ * @param [in] opts: the generator's knobs
+ * @param [out] v1, v2: the sorted regions, with region IDs 2 and 3 like readHexRegion()
+ */
+inline void generateInputs( const genOptions& opts, vector< halfsegment >& v1, vector< halfsegment >& v2 )
+{
+    vector< halfsegment >* regions[] = { &v1, &v2 };
+    v1.clear();
+    v2.clear();
+    generateRegions( opts, [&] ( int r, const vector<genSegment>& segs ) {
+        for( int i = 0; i < segs.size(); i++ ) {
+            halfsegment h;
+            h.dx = segs[i].dx;
+            h.dy = segs[i].dy;
+            h.sx = segs[i].sx;
+            h.sy = segs[i].sy;
+            h.la = h.ola = segs[i].la;
+            h.lb = h.olb = segs[i].lb;
+            h.regionID = r + 2;
+            regions[r]->push_back( h );
+            regions[r]->push_back( h.getBrother() );
+        }
+    });
+    std::sort( v1.begin(), v1.end() );
+    std::sort( v2.begin(), v2.end() );
+}
+
+#endif
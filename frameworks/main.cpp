@@ -17,19 +17,43 @@
 #include <cstdlib>
 #include <algorithm>
 #include "parPlaneSweep.h"
-#include "d2hex.h"
+#include "overlayTrace.h"
+#include "memProbe.h"
+#include "regionFile.h"
 #include <fstream>
 using namespace std;
 
 /**
- * Function that tokenizes a string.  
- * @param [in] str: the string to tokenize
- * @param [out] tokens: a vecotr of string tokens
- * @param [in] delimiters:  A string consisting of delimiters on which to tokenize
+ * Append the timings of one overlay to frameworks.csv as backend,sweep,reconstruct,numStrips.
+ * numStrips is the requested count, so rows group by strip count on every backend
+ * @param [in] stats: the timings filled in by parallelOverlay
  */
-void tokenizeString(const std::string& str, 
-        std::vector<string>& tokens, 
-        const string& delimiters );
+void writeStatsCsv( const OverlayStats& stats );
+
+/**
+ * Append the timings and sizes of one overlay, and of each of its strips, to frameworks.json,
+ * one json object per line.  numStrips counts the strips after heavy strips were split, 
+ * requestedStrips the strips asked for.  Hardware counters per phase and thread are included 
+ * when perf_event_open() is available
+ * @param [in] stats: the timings filled in by parallelOverlay
+ * @param [in] inputMemory: the memory of loading and sorting the input, written ahead of the 
+ *             overlay's phases so each line shows every phase
+ */
+void writeStatsJson( const OverlayStats& stats, const vector<PhaseMemory>& inputMemory );
+
+/**
+ * Print the allocations and resident memory of a phase to cerr
+ * @param [in] memory: the phase, measured by a memoryProbe
+ */
+void printPhaseMemory( const PhaseMemory& memory );
+
+/**
+ * Write the sweep counters as a json member, with a leading comma.  Writes nothing if the 
+ * library was built without SWEEP_COUNTERS
+ * @param [in] json: the stream to write to
+ * @param [in] counters: the counters filled in by parallelOverlay
+ */
+void writeCountersJson( std::ostream& json, const sweepCounters& counters );
 
 
 /**
@@ -46,9 +70,12 @@ void tokenizeString(const std::string& str,
  *  - [an input hex file with region 2]
  *  - [the number of strips to begin running the program with]
  *  - [the number of strips to stop at]
+ *  - optional: [csv, json or none] where to write the timings of each run (default csv)
  *
  *  The program repeatedly runs a plan sweep algorithm on the input
  *  with increasing numbers of strips. Strip counts increase quadratically. 
+ *
+ *  Set PPS_TRACE to a file name to write a Chrome/Perfetto trace of all runs to it.
  */
 int main( int argc, char * argv[] ) 
 {
@@ -57,11 +84,21 @@ int main( int argc, char * argv[] )
     std::string inputFileName1, inputFileName2;
     vector< halfsegment >v1, v2, result;
     int minStrips, maxStrips;
-    if( argc != 5 )
+    string statsFormat = "csv";
+    if( argc != 5 && argc != 6 )
     {
-        std::cerr << "usage: exe  [input file name 1] [input file name 2] [min strips][max strips]" << std::endl;
+        std::cerr << "usage: exe  [input file name 1] [input file name 2] [min strips][max strips] [csv|json|none]" << std::endl;
         exit( -1 );
     }
+    if( argc == 6 )
+    {
+        statsFormat = argv[5];
+        if( statsFormat != "csv" && statsFormat != "json" && statsFormat != "none" )
+        {
+            std::cerr << "unknown stats format: " << statsFormat << ", use csv, json or none" << std::endl;
+            exit( -1 );
+        }
+    }
     {
         std::stringstream ss1;
         ss1 << argv[1];
@@ -83,95 +120,43 @@ int main( int argc, char * argv[] )
         ss1 >> maxStrips;
     }
 
-    ifstream inFileStrm1;
-    inFileStrm1.open( argv[1] );
-    if( ! inFileStrm1 )
+    // the memory of reading and sorting the input, the overlay measures its own phases
+    memoryProbe memProbe;
+    vector<PhaseMemory> inputMemory;
+    memProbe.startPhase( "load" );
+    cerr << "Reading files: " << argv[1] << ", " <<argv[2] << endl;
+    if( !readHexRegion( argv[1], 2, v1 ) )
     {
         cerr << "Error: could not open file: " << argv[1] << endl;
         exit( -1 );
     }
-    ifstream inFileStrm2;
-    inFileStrm2.open( argv[2] );
-    if( ! inFileStrm2 )
+    cerr <<"file 1 finished reading"<<endl;
+    if( !readHexRegion( argv[2], 3, v2 ) )
     {
         cerr << "Error: could not open file: " << argv[2] << endl;
         exit( -1 );
     }
-
-    cerr << "Reading files: " << argv[1] << ", " <<argv[2] << endl;
-    vector<string> splitLine;
-    string line("  ");
-    double x, y;
-    int la, lb;
-    int i = 0;
-    while(inFileStrm1.good() )
-    {
-        getline(inFileStrm1, line);
-        if( inFileStrm1.good() )
-        {
-            if( line.size() == 0 || line[0] == '#' )
-                continue;
-            splitLine.clear();
-            string delim(" \t" );
-            tokenizeString( line, splitLine, delim );
-            v1.push_back( halfsegment() );
-            v1[i].dx = doubleHexConverter::hex2d(splitLine[0]);
-            v1[i].dy = doubleHexConverter::hex2d(splitLine[1]);
-            v1[i].sx = doubleHexConverter::hex2d(splitLine[2]);
-            v1[i].sy = doubleHexConverter::hex2d(splitLine[3]);
-            stringstream ss1( splitLine[4] );
-            ss1 >> la;
-            stringstream ss2( splitLine[5] );
-            ss2 >> lb;
-            v1[i].la = la;
-            v1[i].ola = la;
-            v1[i].lb = lb;
-            v1[i].olb = lb;
-            v1[i].regionID = 2;
-            i++;
-            v1.push_back( v1[i-1].getBrother() );
-            i++;
-        }
-    }
-    cerr <<"file 1 finished reading"<<endl;
-    i = 0;
-    while(inFileStrm2.good() )
-    {
-        getline(inFileStrm2, line);
-        if( inFileStrm2.good() )
-        {
-            if( line.size() == 0 || line[0] == '#' )
-                continue;
-            splitLine.clear();
-            string delim(" \t" );
-            tokenizeString( line, splitLine, delim );
-            v2.push_back( halfsegment() );
-            v2[i].dx = doubleHexConverter::hex2d(splitLine[0]);
-            v2[i].dy = doubleHexConverter::hex2d(splitLine[1]);
-            v2[i].sx = doubleHexConverter::hex2d(splitLine[2]);
-            v2[i].sy = doubleHexConverter::hex2d(splitLine[3]);
-            stringstream ss1( splitLine[4] );
-            ss1 >> la;
-            stringstream ss2( splitLine[5] );
-            ss2 >> lb;
-            v2[i].la = la;
-            v2[i].ola = la;
-            v2[i].lb = lb;
-            v2[i].olb = lb;
-            v2[i].regionID = 3;
-            i++;
-            v2.push_back( v2[i-1].getBrother() );
-            i++;
-        }
-    }
     cerr <<"file 2 finished reading"<<endl;
+    memProbe.stopPhase( inputMemory );
 
 
+    memProbe.startPhase( "sort" );
     std::sort( v1.begin(), v1.end() );
     std::sort( v2.begin(), v2.end() );
+    memProbe.stopPhase( inputMemory );
+    for( int i = 0; i < inputMemory.size(); i++ ) {
+        printPhaseMemory( inputMemory[i] );
+    }
     if( minStrips < 1 ) {
         minStrips = 1;
     }
+    // start the threads once and reuse them for every strip count
+    // set PPS_PIN_THREADS to pin them to cpus
+    OverlayContext context( -1, BACKEND_DEFAULT, getenv( "PPS_PIN_THREADS" ) != NULL );
+    const char *traceFile = getenv( "PPS_TRACE" );
+    if( traceFile != NULL ) {
+        startTrace();
+    }
     for( int i = minStrips; i <= maxStrips; i= (i==1)? 2: i*2 ){
         // start the timer
         cout << "TTT num strips: " << i << endl;
@@ -179,25 +164,137 @@ int main( int argc, char * argv[] )
             overlayPlaneSweep( &(v1[0]), v1.size(), &(v2[0]), v2.size(), result );
         }
         else {
-            parallelOverlay( v1, v2, result, i);
+            OverlayStats stats;
+            parallelOverlay( context, v1, v2, result, i, &stats );
+            if( statsFormat == "csv" ) {
+                writeStatsCsv( stats );
+            }
+            else if( statsFormat == "json" ) {
+                writeStatsJson( stats, inputMemory );
+            }
         }
         cout << "num segs: " << result.size()/2<<endl;
 
     }
+    if( traceFile != NULL && !writeTrace( traceFile ) ) {
+        std::cerr << "could not write the trace to " << traceFile << std::endl;
+    }
+    // system wide, so other processes count too
+    double remote = context.remoteAllocationRatio();
+    if( remote >= 0 ) {
+        cout << "remote numa allocations: " << remote << endl;
+    }
 
 }
 
 
-void tokenizeString(const std::string& str, std::vector<string>& tokens, const string& delimiters )
+void writeStatsCsv( const OverlayStats& stats )
 {
-    std::string::size_type lastPos = str.find_first_not_of(delimiters, 0);	// Skip delimiters at beginning.
-    std::string::size_type pos     = str.find_first_of(delimiters, lastPos);	// Find first "non-delimiter".
+    std::ofstream csv;
+    csv.open( "frameworks.csv", std::ofstream::out | std::ofstream::app );
+    csv << stats.backend << "," << stats.sweepTime << "," << stats.recombineTime << "," << stats.requestedStrips << std::endl;
+    csv.close();
+}
 
-    while (std::string::npos != pos || std::string::npos != lastPos)
-    {
-        tokens.push_back(str.substr(lastPos, pos - lastPos));	        // Found a token, add it to the vector.
-        lastPos = str.find_first_not_of(delimiters, pos);		// Skip delimiters.  Note the "not_of"
-        pos = str.find_first_of(delimiters, lastPos);			// Find next "non-delimiter"
+void writeStatsJson( const OverlayStats& stats, const vector<PhaseMemory>& inputMemory )
+{
+    std::ofstream json;
+    json.open( "frameworks.json", std::ofstream::out | std::ofstream::app );
+    json << "{\"backend\": \"" << stats.backend << "\""
+         << ", \"findBoundsTime\": " << stats.findBoundsTime
+         << ", \"r1StripsTime\": " << stats.r1StripsTime
+         << ", \"r2StripsTime\": " << stats.r2StripsTime
+         << ", \"sweepTime\": " << stats.sweepTime
+         << ", \"recombineTime\": " << stats.recombineTime
+         << ", \"requestedStrips\": " << stats.requestedStrips
+         << ", \"numStrips\": " << stats.numStrips
+         << ", \"r1Segs\": " << stats.r1Segs
+         << ", \"r2Segs\": " << stats.r2Segs
+         << ", \"r1StripSegs\": " << stats.r1StripSegs
+         << ", \"r2StripSegs\": " << stats.r2StripSegs
+         << ", \"resultSegs\": " << stats.resultSegs
+         << ", \"strips\": [";
+    for( int i = 0; i < stats.strips.size(); i++ ) {
+        const StripStats& strip = stats.strips[i];
+        json << ( i == 0 ? "" : ", " )
+             << "{\"leftBound\": " << strip.leftBound
+             << ", \"rightBound\": " << strip.rightBound
+             << ", \"r1Segs\": " << strip.r1Segs
+             << ", \"r2Segs\": " << strip.r2Segs
+             << ", \"splitPieces\": " << strip.splitPieces
+             << ", \"intersections\": " << strip.intersections
+             << ", \"peakActiveList\": " << strip.peakActiveList
+             << ", \"peakEventQueue\": " << strip.peakEventQueue
+             << ", \"resultSegs\": " << strip.resultSegs
+             << ", \"sweepTime\": " << strip.sweepTime
+             << ", \"worker\": " << strip.worker;
+        writeCountersJson( json, strip.counters );
+        json << "}";
     }
+    json << "]";
+    writeCountersJson( json, stats.counters );
+    if( !stats.perf.empty() ) {
+        json << ", \"perf\": [";
+        for( int i = 0; i < stats.perf.size(); i++ ) {
+            const PhasePerf& perf = stats.perf[i];
+            json << ( i == 0 ? "" : ", " )
+                 << "{\"phase\": \"" << perf.phase << "\""
+                 << ", \"worker\": " << perf.worker
+                 << ", \"cycles\": " << perf.cycles
+                 << ", \"instructions\": " << perf.instructions
+                 << ", \"l1dMisses\": " << perf.l1dMisses
+                 << ", \"llcMisses\": " << perf.llcMisses
+                 << ", \"branchMisses\": " << perf.branchMisses << "}";
+        }
+        json << "]";
+    }
+    json << ", \"memory\": [";
+    for( int i = 0; i < inputMemory.size() + stats.memory.size(); i++ ) {
+        const PhaseMemory& memory = ( i < inputMemory.size() ) ? inputMemory[i] : stats.memory[i - inputMemory.size()];
+        json << ( i == 0 ? "" : ", " )
+             << "{\"phase\": \"" << memory.phase << "\""
+             << ", \"allocations\": " << memory.allocations
+             << ", \"frees\": " << memory.frees
+             << ", \"bytesAllocated\": " << memory.bytesAllocated
+             << ", \"bytesFreed\": " << memory.bytesFreed
+             << ", \"rssStart\": " << memory.rssStart
+             << ", \"rssEnd\": " << memory.rssEnd
+             << ", \"peakRss\": " << memory.peakRss << "}";
+    }
+    json << "]";
+    json << "}" << std::endl;
+    json.close();
 }
 
+void writeCountersJson( std::ostream& json, const sweepCounters& counters )
+{
+    if( !counters.enabled ) {
+        return;
+    }
+    json << ", \"counters\": {\"r1Events\": " << counters.r1Events
+         << ", \"r2Events\": " << counters.r2Events
+         << ", \"discoveredEvents\": " << counters.discoveredEvents
+         << ", \"leftEvents\": " << counters.leftEvents
+         << ", \"rightEvents\": " << counters.rightEvents
+         << ", \"alCompares\": " << counters.alCompares
+         << ", \"eventQueueInserts\": " << counters.eventQueueInserts
+         << ", \"breakCalls\": " << counters.breakCalls
+         << ", \"breakHits\": " << counters.breakHits
+         << ", \"colinearOverlaps\": " << counters.colinearOverlaps
+         << ", \"alLengthHistogram\": [";
+    for( int i = 0; i < AL_LENGTH_BUCKETS; i++ ) {
+        json << ( i == 0 ? "" : ", " ) << counters.alLengthHistogram[i];
+    }
+    json << "]}";
+}
+
+void printPhaseMemory( const PhaseMemory& memory )
+{
+    cerr << "memory " << memory.phase << ": peak rss " << memory.peakRss 
+         << ", rss " << memory.rssStart << " -> " << memory.rssEnd;
+    if( memory.allocations >= 0 ) {
+        cerr << ", " << memory.allocations << " allocations of " << memory.bytesAllocated 
+             << " bytes, " << memory.frees << " frees of " << memory.bytesFreed << " bytes";
+    }
+    cerr << endl;
+}
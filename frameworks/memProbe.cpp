@@ -0,0 +1,243 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+
+#include "memProbe.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#ifdef MEM_ACCOUNTING
+#include <new>
+#include <atomic>
+#include <malloc.h>
+#endif
+
+#ifdef MEM_ACCOUNTING
+/**
+ * \struct allocationSlot
+ *
+ * \brief the allocations of one thread.  Only its thread writes a slot, except the last one, 
+ *  which is shared by the threads that found no free slot
+ */
+struct alignas( 64 ) allocationSlot {
+	std::atomic<long long> allocations;
+	std::atomic<long long> frees;
+	std::atomic<long long> bytesAllocated;
+	std::atomic<long long> bytesFreed;
+};
+
+static const int ALLOCATION_SLOTS = 256;
+// zero initialized before any code runs, so operator new works during static initialization
+static allocationSlot allocationSlots[ ALLOCATION_SLOTS ];
+static std::atomic<int> allocationSlotsTaken( 0 );
+static thread_local int threadAllocationSlot = -1;
+
+/// add \a n to a counter of the calling thread's slot
+static inline void addAllocationCount( std::atomic<long long> &count, long long n, bool shared )
+{
+	if( shared ) {
+		count.fetch_add( n, std::memory_order_relaxed );
+	}
+	else {
+		// the only writer, so a plain add that readers see whole
+		count.store( count.load( std::memory_order_relaxed ) + n, std::memory_order_relaxed );
+	}
+}
+
+/// charge an allocation (or a free) of \a p to the calling thread
+static inline void countAllocation( void *p, bool freed )
+{
+	if( threadAllocationSlot < 0 ) {
+		threadAllocationSlot = std::min( (int)allocationSlotsTaken++, ALLOCATION_SLOTS-1 );
+	}
+	allocationSlot &slot = allocationSlots[ threadAllocationSlot ];
+	bool shared = threadAllocationSlot == ALLOCATION_SLOTS-1;
+	// the usable size, so an allocation and its free are charged the same bytes
+	long long bytes = malloc_usable_size( p );
+	if( freed ) {
+		addAllocationCount( slot.frees, 1, shared );
+		addAllocationCount( slot.bytesFreed, bytes, shared );
+	}
+	else {
+		addAllocationCount( slot.allocations, 1, shared );
+		addAllocationCount( slot.bytesAllocated, bytes, shared );
+	}
+}
+
+/// allocate like the standard operator new, but return NULL instead of throwing bad_alloc
+static void *countedAllocate( std::size_t size, std::size_t alignment )
+{
+	if( size == 0 ) {
+		size = 1;
+	}
+	for( ;; ) {
+		void *p = NULL;
+		if( alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__ ) {
+			p = malloc( size );
+		}
+		else if( posix_memalign( &p, alignment, size ) != 0 ) {
+			p = NULL;
+		}
+		if( p != NULL ) {
+			countAllocation( p, false );
+			return p;
+		}
+		std::new_handler handler = std::get_new_handler();
+		if( handler == NULL ) {
+			return NULL;
+		}
+		handler();
+	}
+}
+
+static void *countedNew( std::size_t size, std::size_t alignment )
+{
+	void *p = countedAllocate( size, alignment );
+	if( p == NULL ) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+static void *countedNewNothrow( std::size_t size, std::size_t alignment ) noexcept
+{
+	try {
+		return countedAllocate( size, alignment );
+	}
+	catch( ... ) {
+		return NULL;
+	}
+}
+
+static void countedDelete( void *p ) noexcept
+{
+	if( p != NULL ) {
+		countAllocation( p, true );
+		free( p );
+	}
+}
+
+void *operator new( std::size_t size ) { return countedNew( size, 0 ); }
+void *operator new[]( std::size_t size ) { return countedNew( size, 0 ); }
+void *operator new( std::size_t size, const std::nothrow_t & ) noexcept { return countedNewNothrow( size, 0 ); }
+void *operator new[]( std::size_t size, const std::nothrow_t & ) noexcept { return countedNewNothrow( size, 0 ); }
+void *operator new( std::size_t size, std::align_val_t align ) { return countedNew( size, (std::size_t)align ); }
+void *operator new[]( std::size_t size, std::align_val_t align ) { return countedNew( size, (std::size_t)align ); }
+void *operator new( std::size_t size, std::align_val_t align, const std::nothrow_t & ) noexcept { return countedNewNothrow( size, (std::size_t)align ); }
+void *operator new[]( std::size_t size, std::align_val_t align, const std::nothrow_t & ) noexcept { return countedNewNothrow( size, (std::size_t)align ); }
+
+void operator delete( void *p ) noexcept { countedDelete( p ); }
+void operator delete[]( void *p ) noexcept { countedDelete( p ); }
+void operator delete( void *p, std::size_t ) noexcept { countedDelete( p ); }
+void operator delete[]( void *p, std::size_t ) noexcept { countedDelete( p ); }
+void operator delete( void *p, const std::nothrow_t & ) noexcept { countedDelete( p ); }
+void operator delete[]( void *p, const std::nothrow_t & ) noexcept { countedDelete( p ); }
+void operator delete( void *p, std::align_val_t ) noexcept { countedDelete( p ); }
+void operator delete[]( void *p, std::align_val_t ) noexcept { countedDelete( p ); }
+void operator delete( void *p, std::size_t, std::align_val_t ) noexcept { countedDelete( p ); }
+void operator delete[]( void *p, std::size_t, std::align_val_t ) noexcept { countedDelete( p ); }
+void operator delete( void *p, std::align_val_t, const std::nothrow_t & ) noexcept { countedDelete( p ); }
+void operator delete[]( void *p, std::align_val_t, const std::nothrow_t & ) noexcept { countedDelete( p ); }
+#endif
+
+bool countingAllocations( )
+{
+#ifdef MEM_ACCOUNTING
+	return true;
+#else
+	return false;
+#endif
+}
+
+void readAllocations( PhaseMemory &counts )
+{
+#ifdef MEM_ACCOUNTING
+	counts.allocations = counts.frees = counts.bytesAllocated = counts.bytesFreed = 0;
+	int taken = std::min( (int)allocationSlotsTaken, ALLOCATION_SLOTS );
+	for( int i = 0; i < taken; i++ ) {
+		counts.allocations += allocationSlots[i].allocations.load( std::memory_order_relaxed );
+		counts.frees += allocationSlots[i].frees.load( std::memory_order_relaxed );
+		counts.bytesAllocated += allocationSlots[i].bytesAllocated.load( std::memory_order_relaxed );
+		counts.bytesFreed += allocationSlots[i].bytesFreed.load( std::memory_order_relaxed );
+	}
+#endif
+}
+
+/**
+ *  Read a field in kB from /proc/self/status, in bytes.  Uses stdio, so reading it is not 
+ *  counted as an allocation of the phase
+ */
+static long long readStatusBytes( const char *field )
+{
+	FILE *status = fopen( "/proc/self/status", "r" );
+	if( status == NULL ) {
+		return -1;
+	}
+	long long bytes = -1;
+	char line[ 256 ];
+	int fieldLength = strlen( field );
+	while( fgets( line, sizeof( line ), status ) != NULL ) {
+		if( strncmp( line, field, fieldLength ) == 0 && line[ fieldLength ] == ':' ) {
+			bytes = strtoll( line + fieldLength + 1, NULL, 10 ) * 1024;
+			break;
+		}
+	}
+	fclose( status );
+	return bytes;
+}
+
+long long residentBytes( )
+{
+	return readStatusBytes( "VmRSS" );
+}
+
+long long peakResidentBytes( )
+{
+	return readStatusBytes( "VmHWM" );
+}
+
+bool resetPeakResident( )
+{
+	FILE *clearRefs = fopen( "/proc/self/clear_refs", "w" );
+	if( clearRefs == NULL ) {
+		return false;
+	}
+	// 5 resets the peak resident size (Linux 4.0 and later)
+	bool reset = fputs( "5", clearRefs ) >= 0;
+	return fclose( clearRefs ) == 0 && reset;
+}
+
+void memoryProbe::startPhase( const char *phase )
+{
+	start = PhaseMemory();
+	start.phase = phase;
+	resetPeakResident();
+	start.rssStart = residentBytes();
+	readAllocations( start );
+}
+
+void memoryProbe::stopPhase( vector< PhaseMemory > &results )
+{
+	PhaseMemory end;
+	readAllocations( end );
+	PhaseMemory phase = start;
+	if( countingAllocations() ) {
+		phase.allocations = end.allocations - start.allocations;
+		phase.frees = end.frees - start.frees;
+		phase.bytesAllocated = end.bytesAllocated - start.bytesAllocated;
+		phase.bytesFreed = end.bytesFreed - start.bytesFreed;
+	}
+	phase.rssEnd = residentBytes();
+	phase.peakRss = peakResidentBytes();
+	results.push_back( phase );
+}
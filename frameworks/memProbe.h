@@ -0,0 +1,71 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+
+#include "parPlaneSweep.h"
+
+#ifndef MEMPROBE_H
+#define MEMPROBE_H
+
+/**
+ * \file
+ *
+ * Allocation counts and resident memory for the phases of an overlay, so a run that runs out of
+ * memory shows which phase grew.
+ *
+ * Resident memory is read from /proc/self/status.  The kernel's peak (VmHWM) is reset at the 
+ * start of each phase through /proc/self/clear_refs, so the peak is the phase's own.  If the 
+ * reset is refused the peak is that of the process so far.
+ *
+ * Allocations are counted by replacing the global operator new and delete, which only happens 
+ * when the library is built with: make MEM_ACCOUNTING=1.  The containers use std::allocator, so 
+ * this sees every vector, map and strip without changing their types.  Each thread counts into 
+ * a slot of its own, so counting needs no locked instructions.  The counts are for the whole 
+ * process: every thread and every library that allocates during a phase is charged to it.
+ */
+
+/// true if the global operator new is counting allocations (built with MEM_ACCOUNTING)
+bool countingAllocations( );
+
+/**
+ *  Add up the allocations of all threads since the process started.  Leaves the counts at -1 
+ *  unless built with MEM_ACCOUNTING
+ */
+void readAllocations( PhaseMemory &counts );
+
+/// the resident bytes of the process, -1 if /proc is not available
+long long residentBytes( );
+
+/// the most resident bytes of the process since the last resetPeakResident(), -1 if /proc is not available
+long long peakResidentBytes( );
+
+/// restart peakResidentBytes() from the current resident bytes.  Returns false if the kernel refuses
+bool resetPeakResident( );
+
+/**
+ * \class memoryProbe
+ *
+ * \brief measures the allocations and resident memory of consecutive phases.
+ */
+class memoryProbe {
+public:
+	/// start measuring a phase.  Phases do not overlap
+	void startPhase( const char *phase );
+
+	/// stop measuring the current phase and append it to \a results
+	void stopPhase( vector< PhaseMemory > &results );
+
+private:
+	PhaseMemory start;
+};
+
+#endif
@@ -0,0 +1,232 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+// Microbenchmarks for the geometric kernels of the plane sweep.  Each kernel runs over 
+// fixed-seed inputs in several configurations, including the degenerate ones the sweep has 
+// special cases for, so a change to a kernel can be timed without running a whole overlay.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include "parPlaneSweep.h"
+#include "vectorAlEq.h"
+#include "d2hex.h"
+
+// kernels of the sweep that parPlaneSweep.h does not declare.  libparOverlay exports them
+bool findIntersectionPoint( const halfsegment & h1, const  halfsegment & h2,
+                            double & X, double & Y, bool & colinear );
+bool breakHsegs( const halfsegment &alSeg, halfsegment & origCurr,
+                 vector< halfsegment> & brokenSegs, bool & colinear,
+                 const bool includeCurrSegInBrokenSegs );
+
+/// the number of inputs generated for each configuration
+const int NUM_INPUTS = 4096;
+/// the seed of every input generator, so runs are comparable
+const int SEED = 20160101;
+
+/**
+ * Two halfsegments to feed a kernel, and a sweep line position where both are active
+ */
+struct benchPair {
+    halfsegment h1, h2;
+    double xVal;
+};
+
+/**
+ * Make a left halfsegment between two points with labels 0 (above) and 1 (below)
+ */
+halfsegment makeSeg( double x1, double y1, double x2, double y2 )
+{
+    halfsegment h;
+    h.dx = x1; h.dy = y1; h.sx = x2; h.sy = y2;
+    if( !h.isLeft() ) {
+        h = h.getBrother();
+    }
+    h.la = 0;
+    h.lb = 1;
+    return h;
+}
+
+/**
+ * Generate pairs of halfsegments in one configuration.  Coordinates are integers so the 
+ * degenerate configurations are exact.
+ *
+ * @param [in] config: general (both cross x = 150), vertical (h2 is vertical at x = 150),
+ *                     shared (both start at the same point) or colinear (overlapping on one line)
+ * @param [out] pairs: the generated pairs
+ */
+void generatePairs( const string& config, vector< benchPair >& pairs )
+{
+    std::mt19937 gen( SEED );
+    std::uniform_int_distribution<int> coord( 0, 1000 );
+    std::uniform_int_distribution<int> left( 0, 100 );
+    std::uniform_int_distribution<int> right( 200, 300 );
+    std::uniform_int_distribution<int> step( -5, 5 );
+    pairs.resize( NUM_INPUTS );
+    for( int i = 0; i < NUM_INPUTS; i++ ) {
+        benchPair& p = pairs[i];
+        if( config == "general" ) {
+            p.h1 = makeSeg( left( gen ), coord( gen ), right( gen ), coord( gen ) );
+            p.h2 = makeSeg( left( gen ), coord( gen ), right( gen ), coord( gen ) );
+            p.xVal = 150;
+        }
+        else if( config == "vertical" ) {
+            p.h1 = makeSeg( left( gen ), coord( gen ), right( gen ), coord( gen ) );
+            p.h2 = makeSeg( 150, coord( gen ), 150, coord( gen ) + 1 );
+            p.xVal = 150;
+        }
+        else if( config == "shared" ) {
+            double x = left( gen ), y = coord( gen );
+            p.h1 = makeSeg( x, y, right( gen ), coord( gen ) );
+            p.h2 = makeSeg( x, y, right( gen ), coord( gen ) );
+            p.xVal = x;
+        }
+        else {
+            // points x + t*a, y + t*b along one line, with overlapping ranges of t
+            double x = left( gen ), y = coord( gen );
+            int a = 1 + left( gen ) % 5, b = step( gen );
+            int t1 = left( gen ) % 10, t2 = t1 + 10 + left( gen ) % 10;
+            int t3 = t1 + 1 + left( gen ) % 10, t4 = t3 + 10 + left( gen ) % 10;
+            p.h1 = makeSeg( x + t1*a, y + t1*b, x + t2*a, y + t2*b );
+            p.h2 = makeSeg( x + t3*a, y + t3*b, x + t4*a, y + t4*b );
+            p.xVal = p.h2.dx;
+        }
+    }
+}
+
+/**
+ * Time a kernel.  Runs all NUM_INPUTS inputs through it until at least minSeconds have passed
+ * and prints the time per call.
+ *
+ * @param [in] kernel: the kernel's name
+ * @param [in] config: the input configuration
+ * @param [in] minSeconds: the minimum time to run the kernel
+ * @param [in] body: runs the kernel on input i, returns something depending on the result so
+ *                   the call is not optimized away
+ */
+template< typename Body >
+void timeKernel( const string& kernel, const string& config, double minSeconds, Body body )
+{
+    static volatile double sink;
+    double acc = 0;
+    long long calls = 0;
+    std::chrono::duration<double> elapsed( 0 );
+    std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+    while( elapsed.count() < minSeconds ) {
+        for( int i = 0; i < NUM_INPUTS; i++ ) {
+            acc += body( i );
+        }
+        calls += NUM_INPUTS;
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+    sink = acc;
+    std::cout << std::left << std::setw( 24 ) << kernel << std::setw( 12 ) << config 
+              << std::right << std::fixed << std::setprecision( 2 ) << std::setw( 12 ) 
+              << elapsed.count() * 1e9 / calls << " ns/call" << std::endl;
+}
+
+/**
+ * Runs the microbenchmarks and prints one line per kernel and input configuration
+ *
+ * The command line argument is optional:
+ *  - [the minimum number of seconds to run each benchmark] (default 0.2)
+ */
+int main( int argc, char* argv[] )
+{
+    double minSeconds = 0.2;
+    if( argc > 1 ) {
+        minSeconds = atof( argv[1] );
+    }
+    const char *configs[] = { "general", "vertical", "shared", "colinear" };
+    for( int c = 0; c < 4; c++ ) {
+        const string config = configs[c];
+        vector< benchPair > pairs;
+        generatePairs( config, pairs );
+        activeListVec activeList;
+        vector< halfsegment > brokenSegs;
+
+        timeKernel( "operator<", config, minSeconds, [&] (int i) {
+            return pairs[i].h1 < pairs[i].h2;
+        });
+        timeKernel( "colinear", config, minSeconds, [&] (int i) {
+            return pairs[i].h1.colinear( pairs[i].h2 );
+        });
+        timeKernel( "getYvalAtX", config, minSeconds, [&] (int i) {
+            return pairs[i].h2.getYvalAtX( pairs[i].xVal );
+        });
+        timeKernel( "alHsegLT", config, minSeconds, [&] (int i) {
+            activeList.xVal = pairs[i].xVal;
+            return activeList.alHsegLT( pairs[i].h2, pairs[i].h1 );
+        });
+        timeKernel( "findIntersectionPoint", config, minSeconds, [&] (int i) {
+            double X, Y;
+            bool colinear;
+            return findIntersectionPoint( pairs[i].h1, pairs[i].h2, X, Y, colinear ) ? X : 0;
+        });
+        timeKernel( "breakHsegs", config, minSeconds, [&] (int i) {
+            halfsegment curr = pairs[i].h2;
+            bool colinear;
+            brokenSegs.clear();
+            breakHsegs( pairs[i].h1, curr, brokenSegs, colinear, false );
+            return brokenSegs.size();
+        });
+    }
+
+    // hex conversion of doubles as they appear in the input files
+    std::mt19937 gen( SEED );
+    std::uniform_real_distribution<double> coord( -180, 180 );
+    vector< double > doubles( NUM_INPUTS );
+    vector< string > hexes( NUM_INPUTS );
+    for( int i = 0; i < NUM_INPUTS; i++ ) {
+        doubles[i] = coord( gen );
+        hexes[i] = doubleHexConverter::d2hex( doubles[i] );
+    }
+    timeKernel( "hex2d", "coords", minSeconds, [&] (int i) {
+        return doubleHexConverter::hex2d( hexes[i] );
+    });
+    timeKernel( "d2hex", "coords", minSeconds, [&] (int i) {
+        return doubleHexConverter::d2hex( doubles[i] ).size();
+    });
+
+    // event queue held at a steady size: each call pops the head and inserts one halfsegment
+    // ahead of it, like the discovered intersections of a sweep.  Fractional x offsets keep 
+    // the inserted halfsegments distinct
+    vector< benchPair > segs;
+    generatePairs( "general", segs );
+    std::uniform_real_distribution<double> offset( 0, 1 );
+    for( int i = 0; i < NUM_INPUTS; i++ ) {
+        double dx = offset( gen );
+        segs[i].h1.dx += dx; segs[i].h1.sx += dx;
+        segs[i].h2.dx += dx; segs[i].h2.sx += dx;
+    }
+    int queueSizes[] = { 16, 256, 4096 };
+    for( int s = 0; s < 3; s++ ) {
+        eventQueue queue;
+        for( int i = 0; i < queueSizes[s]; i++ ) {
+            queue.insert( segs[i].h1 );
+        }
+        timeKernel( "eventQueue insert+pop", "size " + std::to_string( queueSizes[s] ), minSeconds, [&] (int i) {
+            halfsegment head, h = segs[i].h2;
+            queue.peek( head );
+            queue.pop();
+            h.dx += head.dx;
+            h.sx += head.dx;
+            queue.insert( h );
+            return queue.size();
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+#include "overlayTrace.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <iomanip>
+
+using namespace std;
+
+/**
+ *  One recorded event.  Times are in microseconds since startTrace()
+ */
+struct traceEvent {
+	const char *name;
+	const char *arg1, *arg2;
+	double value1, value2;
+	double start, duration;
+};
+
+/**
+ *  The events recorded by one thread.  Only that thread appends to it.
+ */
+struct threadTraceBuffer {
+	int tid;
+	vector< traceEvent > events;
+};
+
+static atomic<bool> traceOn( false );
+static chrono::steady_clock::time_point traceStart;
+/// guards buffers.  Taken when a thread records for the first time, and by startTrace() and writeTrace()
+static mutex buffersLock;
+static vector< unique_ptr< threadTraceBuffer > > buffers;
+
+/// the calling thread's buffer, registered on first use
+static threadTraceBuffer & threadBuffer( )
+{
+	static thread_local threadTraceBuffer *buffer = NULL;
+	if( buffer == NULL ) {
+		lock_guard< mutex > guard( buffersLock );
+		buffers.push_back( unique_ptr< threadTraceBuffer >( new threadTraceBuffer ) );
+		buffer = buffers.back().get();
+		buffer->tid = buffers.size();
+	}
+	return *buffer;
+}
+
+void startTrace( )
+{
+	lock_guard< mutex > guard( buffersLock );
+	for( int i = 0; i < buffers.size(); i++ ) {
+		buffers[i]->events.clear();
+	}
+	traceStart = chrono::steady_clock::now();
+	traceOn = true;
+}
+
+bool tracing( )
+{
+	return traceOn.load( memory_order_relaxed );
+}
+
+/// write a name as a json string.  Names are string literals without quotes or backslashes
+static void writeName( ostream &out, const char *name )
+{
+	out << "\"" << name << "\"";
+}
+
+bool writeTrace( const string &fileName )
+{
+	traceOn = false;
+	lock_guard< mutex > guard( buffersLock );
+	ofstream out( fileName.c_str() );
+	if( !out ) {
+		return false;
+	}
+	out << fixed << setprecision( 3 );
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+	bool first = true;
+	for( int i = 0; i < buffers.size(); i++ ) {
+		const threadTraceBuffer &buffer = *buffers[i];
+		if( buffer.events.empty() ) {
+			continue;
+		}
+		out << ( first ? "" : ",\n" ) << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " 
+				<< buffer.tid << ", \"args\": {\"name\": \"thread " << buffer.tid << "\"}}";
+		first = false;
+		for( int j = 0; j < buffer.events.size(); j++ ) {
+			const traceEvent &e = buffer.events[j];
+			out << ",\n{\"name\": ";
+			writeName( out, e.name );
+			out << ", \"cat\": \"overlay\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer.tid
+					<< ", \"ts\": " << e.start << ", \"dur\": " << e.duration << ", \"args\": {";
+			if( e.arg1 != NULL ) {
+				writeName( out, e.arg1 );
+				out << ": " << setprecision( 6 ) << defaultfloat << e.value1;
+			}
+			if( e.arg2 != NULL ) {
+				out << ", ";
+				writeName( out, e.arg2 );
+				out << ": " << e.value2;
+			}
+			out << fixed << setprecision( 3 ) << "}}";
+		}
+	}
+	out << "\n]}" << endl;
+	return (bool) out;
+}
+
+traceScope::traceScope( const char *name, const char *arg1, double value1, const char *arg2, double value2 ) 
+	: name( name ), arg1( arg1 ), arg2( arg2 ), value1( value1 ), value2( value2 ), recording( tracing() )
+{
+	if( recording ) {
+		start = chrono::steady_clock::now();
+	}
+}
+
+traceScope::~traceScope( )
+{
+	if( !recording ) {
+		return;
+	}
+	chrono::steady_clock::time_point end = chrono::steady_clock::now();
+	traceEvent e;
+	e.name = name;
+	e.arg1 = arg1;
+	e.arg2 = arg2;
+	e.value1 = value1;
+	e.value2 = value2;
+	e.start = chrono::duration<double, micro>( start - traceStart ).count();
+	e.duration = chrono::duration<double, micro>( end - start ).count();
+	threadBuffer().events.push_back( e );
+}
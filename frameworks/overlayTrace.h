@@ -0,0 +1,74 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+#include <string>
+#include <chrono>
+
+#ifndef OVERLAYTRACE_H
+#define OVERLAYTRACE_H
+
+/**
+ * \file
+ *
+ * An opt-in tracer for the parallel overlay.  While tracing, the overlay records when each
+ * thread created the strips, swept each strip, linked neighboring strips and ran each 
+ * recombine step.  writeTrace() saves the events as Chrome trace event json, which loads in
+ * Perfetto (ui.perfetto.dev) or chrome://tracing and shows which thread ran what, and where
+ * threads sat idle.
+ *
+ * Each thread records into its own buffer, so recording takes no lock.  A thread's buffer is
+ * registered (under a lock) the first time it records.  Buffers outlive their threads, so 
+ * tracing may span several OverlayContexts.
+ */
+
+/// start recording, dropping anything recorded before
+void startTrace( );
+
+/// true while recording
+bool tracing( );
+
+/**
+ *  Stop recording and write the events recorded since startTrace() to a file.  Call it while
+ *  no overlay is running.
+ *
+ *  \param fileName the json file to write
+ *  \return false if the file could not be written
+ */
+bool writeTrace( const std::string &fileName );
+
+/**
+ * \class traceScope
+ *
+ * \brief records one event from its construction to its destruction, if tracing is on.
+ *
+ *  Up to two numeric arguments are shown with the event.  Names must be string literals, they
+ *  are not copied.
+ */
+class traceScope {
+public:
+	traceScope( const char *name, const char *arg1 = NULL, double value1 = 0, 
+							const char *arg2 = NULL, double value2 = 0 );
+	~traceScope( );
+
+private:
+	traceScope( const traceScope& );
+	traceScope& operator=( const traceScope& );
+
+	const char *name;
+	const char *arg1, *arg2;
+	double value1, value2;
+	/// false if tracing was off when the scope started
+	bool recording;
+	std::chrono::steady_clock::time_point start;
+};
+
+#endif
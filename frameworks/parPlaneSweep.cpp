@@ -10,12 +10,25 @@
  * */
 /* Code modified or added by Eric Lehmann will be marked ELEHMANN */
 
+// All parallel loops run on an executor (see executor.h), so the same library runs on 
+// OpenMP, TBB, C++17 parallel algorithms or a work stealing thread pool.
+
 #include <iomanip>
-#include <omp.h>
 #include "parPlaneSweep.h"
+#include "executor.h"
+#include "perfProbe.h"
+#include "memProbe.h"
+#include "overlayTrace.h"
 #include "vectorAlEq.h"
 #include <limits>
 #include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+
+#ifdef SWEEP_COUNTERS
+thread_local sweepCounters threadSweepCounters;
+#endif
 
 /**
  * A binary search function
@@ -97,23 +110,6 @@ void createStrips( vector< halfsegment> & region, vector<double> &isoBounds,
 
 
 
-/**
- * This function calls the individual overlay functions.  It simply sets up calls
- * to overlayPlaneSweep().
- *
- * It is expected that the overlayPlaneSweep() function splits up the input into 
- * strips, and then passes those strips to this function.
- *
- * The start and stop indexes indcate where each strip starts in the r1Strips and r2Strips vectors.
- */
-void partialOverlay( 	const vector<halfsegment> & r1Strips, const vector<halfsegment> & r2Strips,
-											vector<halfsegment> & result, 
-											vector< int > &r1StripStopIndex, vector< int > &r2StripStopIndex, 
-											const int stripID );
-
-
-
-
 /**
  *  Find the intersection point between two halfsegments.  Also indicate if they are colinear.  
  */
@@ -129,14 +125,137 @@ bool breakHsegs( const halfsegment &alSeg, halfsegment & origCurr,
 								 const bool includeCurrSegInBrokenSegs );
 
 /**
- *  Remove breaks in halfsegments that are only introduced to create strips.
- *  
- *  This is not strictly necessary, but removes breaks in halfsegemnts 
- *  that were introduced solely for the purpose of createing strips
+ *  The endpoints of a strip's halfsegments that lie on the strip's iso bounds, keyed by y value.
+ *  Built right after the strip is swept so that stitching never has to search a whole strip.
  */
-void createFinalOverlay( vector<halfsegment> & finalResult,
-												 vector< vector<halfsegment> > &resultStrips, 
-												 const vector<double> &isoBounds );
+struct stripBoundaryIndex {
+	/// left hsegs ending on the right iso bound.  y -> (number of hsegs ending at y, index of the first one)
+	unordered_map< double, pair<int,int> > rightEnds;
+	/// left hsegs starting on the left iso bound.  y -> index of the first one
+	unordered_map< double, int > leftStarts;
+};
+
+/// a strip is split before it is swept if it holds more than 1/(STRIP_SPLIT_FACTOR * number of threads) of all halfsegments
+const int STRIP_SPLIT_FACTOR = 4;
+/// strips with fewer halfsegments than this are never split, the sweep is cheaper than the split
+const int STRIP_MIN_SPLIT_SIZE = 2048;
+
+/**
+ *  A strip waiting to be swept.  r1 and r2 point to the pieces of both regions that fall in 
+ *  [leftBound, rightBound].  They point into the strips built by createStrips(), or into
+ *  r1Pieces and r2Pieces once the strip has been split.
+ */
+struct stripWork {
+	double leftBound, rightBound;
+	const halfsegment *r1, *r2;
+	int r1Size, r2Size;
+	vector<halfsegment> r1Pieces, r2Pieces;
+};
+
+/**
+ *  A swept strip, with the links from its pieces to the pieces of the strip to its right.
+ */
+struct sweptStrip {
+	double leftBound, rightBound;
+	vector<halfsegment> result;
+	stripBoundaryIndex index;
+	vector< pair<int,int> > links;
+	unordered_map<int,int> nextPiece;
+	/// telemetry, only filled in if it was asked for
+	StripStats stats;
+};
+
+/**
+ *  Sweep a strip.  If the strip is heavier than maxStripSize, it is split in two first, and 
+ *  the halves are swept as a nested parallel loop so an idle thread can pick one up.  The 
+ *  halves are split again if they are still too heavy, and linked across the new bound once 
+ *  both are swept.  overlayStrips() only sets maxStripSize below the size of all input when 
+ *  the executor splits heavy strips (the pool backend) and has more than one thread.
+ *
+ *  Like running with more strips, splitting adds iso bounds, so the intersections near them are
+ *  computed on different pieces.  A run that split strips is not bit-identical to one that 
+ *  did not, and can have a slightly different number of halfsegments.
+ *
+ *  \param work the strip to sweep.  Deleted when done.
+ *  \param collectStats fill in the StripStats of each swept piece
+ *  \param swept [out] the swept pieces of the strip, in x order
+ */
+void sweepStrip( executor &exec, stripWork *work, int maxStripSize, bool collectStats, 
+								 vector< sweptStrip* > &swept );
+
+/**
+ *  Split a strip in two at a new iso bound.  The strip's halfsegments are sorted, so the bound
+ *  is placed right after the median dominating x value of the larger region, halfway to the
+ *  next endpoint.  Like the other iso bounds, it never falls on an endpoint.
+ *
+ *  \param work [in/out] the strip to split.  Keeps the left half.
+ *  \return the right half, or NULL if there is no room for a new bound
+ */
+stripWork * splitStrip( stripWork &work );
+
+/**
+ *  Break the pieces of one region at x.  Works like createStrips() for a single bound.
+ *
+ *  \param pieces the sorted pieces of one region in a strip
+ *  \param left [out] the sorted pieces left of x
+ *  \param right [out] the sorted pieces right of x
+ */
+void splitRegionAt( const halfsegment *pieces, int size, double x, 
+										vector<halfsegment> &left, vector<halfsegment> &right );
+
+/**
+ *  Index the halfsegments of a swept strip that start or end on the strip's iso bounds.
+ *
+ *  \param strip the sorted result of sweeping the strip between leftBound and rightBound
+ *  \param index [out] the boundary endpoints of the strip
+ */
+void indexStripBoundaries( const vector<halfsegment> &strip, const double leftBound,
+													 const double rightBound, stripBoundaryIndex &index );
+
+/**
+ *  Parallel version of createFinalOverlay().  Produces the same halfsegments in the same order,
+ *  which stitchTest checks.
+ *
+ *  The pieces on either side of each iso bound are linked by linkStripPieces() while the 
+ *  strips are still being swept, and StripedOverlayResult::markChains() marks the pieces that
+ *  continue a chain started in an earlier strip.  Every other valid left halfsegment starts a 
+ *  chain.  A prefix sum over the number of chain starts in each strip gives each strip its 
+ *  offset in finalResult, then every strip (in parallel) follows its chains and writes the 
+ *  joined halfsegments at its offset.  Strips without links are copied straight through.
+ *
+ *  \param striped the swept, linked and marked strips
+ */
+void parallelCreateFinalOverlay( vector<halfsegment> & finalResult,
+																 const StripedOverlayResult &striped, executor &exec );
+
+/**
+ *  Split the regions into strips, sweep the strips, and link the pieces across the iso bounds.
+ *  All versions of parallelOverlay() are wrappers around this.
+ *
+ *  \param exec the backend every loop runs on
+ *  \param striped [out] the overlay, left in strips
+ *  \param result [out] if not NULL, the strips are also stitched into this vector
+ *  \param localStrips copy each strip into buffers first touched by the thread that sweeps it,
+ *                     see OverlayContext::placesStripsLocally()
+ *  \param stats [out] if not NULL, filled in with the timings and sizes of the overlay
+ */
+void overlayStrips( executor &exec, vector<halfsegment> &r1, vector<halfsegment> &r2, 
+										StripedOverlayResult &striped, vector<halfsegment> *result, int numStrips,
+										bool localStrips = false, OverlayStats *stats = NULL );
+
+/**
+ *  Link the pieces across the iso bound between two neighboring strips.  Called as soon as 
+ *  both strips are swept and indexed.
+ *
+ *  For each left halfsegment in the left strip that ends on the bound, and is the only 
+ *  halfsegment ending at that point, record the index of the halfsegment in the right
+ *  strip that it continues into.
+ *
+ *  \param links [out] (index in the left strip, index in the right strip) pairs
+ *  \param nextPiece [out] index in the left strip -> index in the right strip
+ */
+void linkStripPieces( const stripBoundaryIndex &left, const stripBoundaryIndex &right,
+											vector< pair<int,int> > &links, unordered_map<int,int> &nextPiece );
 
 
 /**
@@ -155,123 +274,298 @@ void insertBrokenSegsToActiveListAndDiscoveredQueue( const vector<halfsegment> &
  * See the prototype in parPlaneSweep.h
  */
 void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, vector<halfsegment> &result, 
-							int numStrips, int numWorkerThreads )
+							int numStrips, int numWorkerThreads, overlayBackend backend, OverlayStats *stats )
+{
+	OverlayContext context( numWorkerThreads, backend );
+	parallelOverlay( context, r1, r2, result, numStrips, stats );
+}
+
+/**
+ * See the prototype in parPlaneSweep.h
+ */
+void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, StripedOverlayResult &result, 
+							int numStrips, int numWorkerThreads, overlayBackend backend, OverlayStats *stats )
+{
+	OverlayContext context( numWorkerThreads, backend );
+	parallelOverlay( context, r1, r2, result, numStrips, stats );
+}
+
+/**
+ * See the prototype in parPlaneSweep.h
+ */
+void parallelOverlay( OverlayContext &context, vector<halfsegment> &r1, vector<halfsegment> &r2, 
+											vector<halfsegment> &result, int numStrips, OverlayStats *stats )
+{
+	StripedOverlayResult striped;
+	overlayStrips( context.getExecutor(), r1, r2, striped, &result, numStrips, context.placesStripsLocally(), stats );
+}
+
+/**
+ * See the prototype in parPlaneSweep.h
+ */
+void parallelOverlay( OverlayContext &context, vector<halfsegment> &r1, vector<halfsegment> &r2, 
+											StripedOverlayResult &result, int numStrips, OverlayStats *stats )
 {
+	overlayStrips( context.getExecutor(), r1, r2, result, NULL, numStrips, context.placesStripsLocally(), stats );
+}
+
+/**
+ * See the prototype in parPlaneSweep.h
+ */
+std::future<void> parallelOverlayAsync( OverlayContext &context, vector<halfsegment> &r1, 
+																				vector<halfsegment> &r2, vector<halfsegment> &result, 
+																				int numStrips, OverlayStats *stats )
+{
+	return context.getExecutor().async( [&context, &r1, &r2, &result, numStrips, stats] {
+		parallelOverlay( context, r1, r2, result, numStrips, stats );
+	});
+}
+
+/**
+ * See the prototype in parPlaneSweep.h
+ */
+std::future<void> parallelOverlayAsync( OverlayContext &context, vector<halfsegment> &r1, 
+																				vector<halfsegment> &r2, StripedOverlayResult &result, 
+																				int numStrips, OverlayStats *stats )
+{
+	return context.getExecutor().async( [&context, &r1, &r2, &result, numStrips, stats] {
+		parallelOverlay( context, r1, r2, result, numStrips, stats );
+	});
+}
+
+void overlayStrips( executor &baseExec, vector<halfsegment> &r1, vector<halfsegment> &r2, 
+										StripedOverlayResult &striped, vector<halfsegment> *result, int numStrips,
+										bool localStrips, OverlayStats *stats )
+{
+	// with stats requested, run through a probe that reads the hardware counters of each phase
+	PhasePerf perfCheck;
+	perfProbeExecutor probe( baseExec );
+	bool probing = stats != NULL && readThreadPerf( perfCheck );
+	executor &exec = probing ? probe : baseExec;
+	vector< PhasePerf > perf;
+	// and one that reads the allocations and resident memory of each phase
+	memoryProbe memProbe;
+	vector< PhaseMemory > memory;
+
 	vector<halfsegment> r1Strips, r2Strips;
-	vector< double > isoBounds;
-	vector< vector< halfsegment> > resultStrips;
 	vector< int > r1StripStopIndex, r2StripStopIndex;
-	result.clear();  // make sure the result vec is clear
+	striped.clear();  // make sure the result is clear
+	if( result != NULL ) {
+		result->clear();
+	}
 
-		// set default parallel values
+	// set default parallel values
 	if( numStrips < 0 ) {
-		numStrips = omp_get_num_procs();
+		numStrips = exec.concurrency();
 	}
-	if( numWorkerThreads > 0 ) {
-		omp_set_num_threads( numWorkerThreads );
-	}
-
+	traceScope trace( "overlay", "strips", numStrips );
 
 	int numIsoBounds = numStrips+1;
-
-	// set up vectors for split points, return strips
-	for( int i = 0; i < numStrips; i++ ) {
-		resultStrips.push_back( vector<halfsegment>() );
-	}
+	vector< double > isoBounds;
 	for( int i = 0; i < numIsoBounds; i++ ) {
 		isoBounds.push_back( 0 );
 	} 
 	
 	// find split points
-	findIsoBoundaries( r1, r2, isoBounds );
+	if( stats != NULL ) memProbe.startPhase( "bounds" );
+	if( probing ) probe.startPhase( "bounds" );
+	std::chrono::time_point<std::chrono::system_clock> bounds_start = std::chrono::system_clock::now();
+	{
+		traceScope trace( "find bounds" );
+		findIsoBoundaries( r1, r2, isoBounds );
+	}
+	std::chrono::duration<double> bounds_duration = std::chrono::system_clock::now() - bounds_start;
+	if( probing ) probe.stopPhase( perf );
+	if( stats != NULL ) memProbe.stopPhase( memory );
 
 	// split up the regions at the iso boundaries
- #pragma omp parallel for
-	for( int i = 0; i < 2; i++ ){
+	std::chrono::duration<double> strips_duration[2];
+	if( stats != NULL ) memProbe.startPhase( "strips" );
+	if( probing ) probe.startPhase( "strips" );
+	exec.parallelFor( 2, [&] (int i) {
+		traceScope trace( "create strips", "region", i+1 );
+		std::chrono::time_point<std::chrono::system_clock> strips_start = std::chrono::system_clock::now();
 		if( i == 0 ) createStrips( r1, isoBounds, r1Strips, r1StripStopIndex );
 		else  createStrips( r2, isoBounds, r2Strips, r2StripStopIndex );
-	}
-	// {
-	// 	int count, total = 0;
-	// 	cout << "Number of segmenents in each strip (r1): , "; 
-	// 		for( int i = 0; i < r1StripStopIndex.size( ); i++ ) {
-	// 			count = r1StripStopIndex[i];
-	// 			if( i > 0 ) count -= r1StripStopIndex[i-1];
-	// 			total += count;
-	// 			cout << count << ",";
-	// 		} 
-	// 		cout << "\ntotal segments in all strips:, "<< total << endl;
-	// 		total = 0;
-	// 		cout << "Number of segmenents in each strip (r2): , "; 
-	// 		for( int i = 0; i < r2StripStopIndex.size( ); i++ ) {
-	// 			count = r2StripStopIndex[i];
-	// 			if( i > 0 ) count -= r2StripStopIndex[i-1];
-	// 			total += count;
- 	// 			cout << count << ",";
-	// 		} 
-	// 		cout << "\ntotal segments in all strips:, "<< total << endl;
-	// }
+		strips_duration[i] = std::chrono::system_clock::now() - strips_start;
+	});
+	if( probing ) probe.stopPhase( perf );
+	if( stats != NULL ) memProbe.stopPhase( memory );
 
 	// do the actual plane sweeps
-// ELEHMANN calls to std::chrono and csv output are modified. The rest is original
+// ELEHMANN calls to std::chrono are modified. The rest is original
 // code from McKenney
+	if( stats != NULL ) memProbe.startPhase( "sweep" );
+	if( probing ) probe.startPhase( "sweep" );
 	std::chrono::time_point<std::chrono::system_clock> sweep_start = std::chrono::system_clock::now();
-#pragma omp parallel for schedule(dynamic,1)  
+	// splitting a heavy strip only pays off if an idle thread can steal one of the halves, so
+	// never with a single thread
+	int maxStripSize = std::numeric_limits<int>::max();
+	if( exec.splitsHeavyStrips() && exec.concurrency() > 1 ) {
+		maxStripSize = std::max( STRIP_MIN_SPLIT_SIZE, 
+														 (int)( (r1Strips.size() + r2Strips.size()) / (STRIP_SPLIT_FACTOR * exec.concurrency()) ) );
+	}
+	// the swept pieces of each strip, in x order.  A strip has more than one piece if it was split
+	vector< vector< sweptStrip* > > swept( numStrips );
+	// the number of strips next to each iso bound that are not swept yet
+	vector< std::atomic<int> > boundaryPending( numStrips );
 	for( int i = 0; i < numStrips; i++ ) {
-		partialOverlay( r1Strips, r2Strips, resultStrips[i], r1StripStopIndex, r2StripStopIndex, i );
+		boundaryPending[i] = 2;
 	}
+	exec.parallelFor( numStrips, [&] (int i) {
+		stripWork *work = new stripWork;
+		work->leftBound = isoBounds[i];
+		work->rightBound = isoBounds[i+1];
+		int r1Start = ( i == 0 ) ? 0 : r1StripStopIndex[i-1];
+		int r2Start = ( i == 0 ) ? 0 : r2StripStopIndex[i-1];
+		work->r1 = r1Strips.data() + r1Start;
+		work->r1Size = r1StripStopIndex[i] - r1Start;
+		work->r2 = r2Strips.data() + r2Start;
+		work->r2Size = r2StripStopIndex[i] - r2Start;
+		if( localStrips ) {
+			// createStrips() touched the strips from one thread, so they may sit on another node.
+			// Copy them into buffers this (pinned) thread touches first.  The sweep result is 
+			// allocated here as well, so it is local already
+			work->r1Pieces.assign( work->r1, work->r1 + work->r1Size );
+			work->r2Pieces.assign( work->r2, work->r2 + work->r2Size );
+			work->r1 = work->r1Pieces.data();
+			work->r2 = work->r2Pieces.data();
+		}
+		sweepStrip( exec, work, maxStripSize, stats != NULL, swept[i] );
+		// stitch across the iso bound on either side of this strip as soon as both strips are swept
+		for( int b = i-1; b <= i; b++ ) {
+			if( b >= 0 && b+1 < numStrips && --boundaryPending[b] == 0 ) {
+				traceScope trace( "link strips", "x", isoBounds[b+1] );
+				sweptStrip *left = swept[b].back();
+				linkStripPieces( left->index, swept[b+1].front()->index, left->links, left->nextPiece );
+			}
+		}
+	});
 	std::chrono::time_point<std::chrono::system_clock> sweep_end = std::chrono::system_clock::now();
+	if( probing ) probe.stopPhase( perf );
+	if( stats != NULL ) memProbe.stopPhase( memory );
 
 	// create the final overlay
+	vector< StripStats > stripStats;
+	sweepCounters counters;
+	if( stats != NULL ) memProbe.startPhase( "recombine" );
+	if( probing ) probe.startPhase( "recombine" );
 	std::chrono::time_point<std::chrono::system_clock> reconstruct_start = std::chrono::system_clock::now();
-	createFinalOverlay(  result,
-										 resultStrips, 
-												isoBounds );
+	for( int i = 0; i < numStrips; i++ ) {
+		for( int j = 0; j < swept[i].size(); j++ ) {
+			sweptStrip *piece = swept[i][j];
+			striped.isoBounds.push_back( piece->leftBound );
+			striped.resultStrips.push_back( vector<halfsegment>() );
+			striped.resultStrips.back().swap( piece->result );
+			striped.links.push_back( vector< pair<int,int> >() );
+			striped.links.back().swap( piece->links );
+			striped.nextPiece.push_back( unordered_map<int,int>() );
+			striped.nextPiece.back().swap( piece->nextPiece );
+			if( stats != NULL ) {
+				stripStats.push_back( piece->stats );
+				counters.add( piece->stats.counters );
+			}
+			delete piece;
+		}
+	}
+	striped.isoBounds.push_back( isoBounds.back() );
+	{
+		traceScope trace( "mark chains" );
+		striped.markChains();
+	}
+	if( result != NULL ) {
+		parallelCreateFinalOverlay( *result, striped, exec );
+	}
 
 	std::chrono::time_point<std::chrono::system_clock> reconstruct_end = std::chrono::system_clock::now();
+	if( probing ) probe.stopPhase( perf );
+	if( stats != NULL ) memProbe.stopPhase( memory );
 	std::chrono::duration<double> sweep_duration = sweep_end - sweep_start;
 	std::chrono::duration<double> reconstruct_duration = reconstruct_end - reconstruct_start;
 
-	std::ofstream csv;
-	csv.open("frameworks.csv", std::ofstream::out | std::ofstream::app);
-	csv << "orig," << sweep_duration.count() << "," << reconstruct_duration.count() << "," << numStrips << std::endl;
-	csv.close();
+	if( stats != NULL ) {
+		stats->backend = exec.name();
+		stats->findBoundsTime = bounds_duration.count();
+		stats->r1StripsTime = strips_duration[0].count();
+		stats->r2StripsTime = strips_duration[1].count();
+		stats->sweepTime = sweep_duration.count();
+		stats->recombineTime = reconstruct_duration.count();
+		stats->requestedStrips = numStrips;
+		stats->numStrips = striped.numStrips();
+		stats->r1Segs = r1.size();
+		stats->r2Segs = r2.size();
+		stats->r1StripSegs = r1Strips.size();
+		stats->r2StripSegs = r2Strips.size();
+		stats->resultSegs = 0;
+		for( int i = 0; i < striped.numStrips(); i++ ) {
+			stats->resultSegs += striped.resultStrips[i].size();
+		}
+		if( result != NULL ) {
+			stats->resultSegs = result->size();
+		}
+		stats->strips.swap( stripStats );
+		stats->counters = counters;
+		stats->perf.swap( perf );
+		stats->memory.swap( memory );
+	}
 //END
 }
 
-// call the individual overlay functions.
-// this function just sets up the function calls to overlayPlaneSweep
 /**
  * See the prototype in parPlaneSweep.h
  */
-void partialOverlay( 	const vector<halfsegment> & r1Strips, const vector<halfsegment> & r2Strips,
-											vector<halfsegment> & result, 
-											vector< int > &r1StripStopIndex, vector< int > &r2StripStopIndex, 
-											const int stripID )
+void overlayBatch( OverlayContext &context, vector< pair< vector<halfsegment>, vector<halfsegment> > > &pairs,
+									 vector< vector<halfsegment> > &results, int minStripedSize )
 {
-	
-	int r1Start, r2Start, r1Stop, r2Stop;
-	if( stripID == 0 ) {
-		r1Start = r2Start = 0;
+	executor &exec = context.getExecutor();
+	results.clear();
+	results.resize( pairs.size() );
+	// split the batch into pairs worth striping and pairs swept serially
+	vector< int > large, small;
+	for( int i = 0; i < pairs.size(); i++ ) {
+		if( pairs[i].first.size() + pairs[i].second.size() >= minStripedSize ) {
+			large.push_back( i );
+		}
+		else {
+			small.push_back( i );
+		}
+	}
+	auto stripedOverlay = [&] (int i) {
+		StripedOverlayResult striped;
+		overlayStrips( exec, pairs[i].first, pairs[i].second, striped, &results[i], -1, 
+									 context.placesStripsLocally() );
+	};
+	auto serialOverlay = [&] (int i) {
+		overlayPlaneSweep( pairs[i].first.data(), pairs[i].first.size(), 
+											 pairs[i].second.data(), pairs[i].second.size(), results[i] );
+	};
+	if( exec.stealsWork() ) {
+		// one loop, large pairs first.  Their strips are nested loops that idle threads steal from
+		exec.parallelFor( large.size() + small.size(), [&] (int k) {
+			if( k < large.size() ) {
+				stripedOverlay( large[k] );
+			}
+			else {
+				serialOverlay( small[ k-large.size() ] );
+			}
+		});
 	}
 	else {
-		r1Start = r1StripStopIndex[stripID-1];
-		r2Start = r2StripStopIndex[stripID-1];
+		// nested loops would run serially, so give each large pair all the threads
+		for( int k = 0; k < large.size(); k++ ) {
+			stripedOverlay( large[k] );
+		}
+		exec.parallelFor( small.size(), [&] (int k) {
+			serialOverlay( small[k] );
+		});
 	}
-	r1Stop = r1StripStopIndex[stripID];
-	r2Stop = r2StripStopIndex[stripID];
-
-	overlayPlaneSweep( &(r1Strips[r1Start]), r1Stop-r1Start, 
-										&(r2Strips[r2Start]), r2Stop-r2Start,
-										 result);
 }
-
 /**
  * See the prototype in parPlaneSweep.h
  */
 void overlayPlaneSweep( const halfsegment r1[], int r1Size, 
 												const halfsegment r2[], int r2Size, 
-												vector<halfsegment>& result )
+												vector<halfsegment>& result, StripStats *stats )
 {
 	halfsegment currSeg, maxSeg, tmpSeg, *tmpSegPtr;
 	maxSeg.dx = maxSeg.dy = maxSeg.sx = maxSeg.sy = std::numeric_limits<double>::max();
@@ -302,15 +596,23 @@ void overlayPlaneSweep( const halfsegment r1[], int r1Size,
                         segSource = 3;
                     }
                 }
+		if( stats != NULL ) {
+			stats->peakActiveList = std::max( stats->peakActiveList, activeList.size() );
+			stats->peakEventQueue = std::max( stats->peakEventQueue, discoveredSegs.size() );
+		}
+		SWEEP_COUNT_AL_LENGTH( activeList.size() );
 		// remove the next seg from its source
 		if( segSource == 3 ) {
 			discoveredSegs.pop();
+			SWEEP_COUNT( discoveredEvents );
 		}
 		else if( segSource == 2 ){
 			r2Pos++;
+			SWEEP_COUNT( r2Events );
 		}
 		else {
 			r1Pos++;
+			SWEEP_COUNT( r1Events );
 		}
 		
 		// set current event point.
@@ -323,6 +625,7 @@ void overlayPlaneSweep( const halfsegment r1[], int r1Size,
 		// If curr is a left seg, insert it and check for intersections with neighbors
 		// Else it is a right seg, remove it and check its neighbors for intersections
 		if( currSeg.isLeft( ) ) {
+			SWEEP_COUNT( leftEvents );
 			// initialize the overlap labels
 			currSeg.ola = currSeg.olb = -1;
 			// insert the left seg
@@ -392,6 +695,7 @@ void overlayPlaneSweep( const halfsegment r1[], int r1Size,
 					// Labels are now computed
 					// Compute the segment intersections:
 					if(breakHsegs(  belowSegCopy, currSeg, brokenSegs, colinearIntersection, false ) ){
+						if( stats != NULL ) stats->intersections++;
 					        // cerr << "attempt to erase below: " << belowSegCopy << " " <<segIndex << endl;
                                                 needToRemoveCurr = true;
 						// remove below seg
@@ -403,6 +707,7 @@ void overlayPlaneSweep( const halfsegment r1[], int r1Size,
 				// compute intersections with above seg:
 				if( hasAbove ) {
 					if( breakHsegs(  aboveSegCopy, currSeg, brokenSegs, colinearIntersection, false ) ) {
+						if( stats != NULL ) stats->intersections++;
 					        //cerr << "attempt to erase above: " << aboveSegCopy << " " <<segIndex << endl;
 						
                                             needToRemoveCurr = true;
@@ -424,6 +729,7 @@ void overlayPlaneSweep( const halfsegment r1[], int r1Size,
 		}
 		else {
 			// This is a right halfsegment. 
+			SWEEP_COUNT( rightEvents );
 			// find its brother (left halfsegment) in the active list,
 			//      remove it, and check its neighbors for intersections.  
 			currSeg = currSeg.getBrother();
@@ -450,6 +756,7 @@ void overlayPlaneSweep( const halfsegment r1[], int r1Size,
                                     // cerr << "check above/below for inters"<<endl;
 					brokenSegs.clear();
 					if(breakHsegs(  belowCopy, aboveCopy, brokenSegs, colinearIntersection, true ) ){
+						if( stats != NULL ) stats->intersections++;
                                                 // if we got here, we are done updating labels, so we
                                                 // can kill iterators in the active list by deleting
                                                 //activeList.replace( tmpSeg, aboveCopy);
@@ -535,8 +842,11 @@ bool breakHsegs( const halfsegment &alSeg, halfsegment & origCurr,
 	bool foundIntersection;
 	// get the intersecion point
 	double X,Y;
+	SWEEP_COUNT( breakCalls );
 	if( foundIntersection = findIntersectionPoint( h2, curr, X, Y, colinear ) ) {
+		SWEEP_COUNT( breakHits );
 		if( colinear ) {
+			SWEEP_COUNT( colinearOverlaps );
 			// If the segs are colinear, their intersection can have at most 3 components
 			//  1) one seg begins to the left (or below) the other. (non overlapping part)
 			//  2) the portion of the segs that overlap
@@ -734,10 +1044,6 @@ void createStrips( vector< halfsegment> & region, vector<double> &isoBounds,
 				}
 			}
 		}
-		for ( auto it = rStrips.begin(); it != rStrips.end(); it++){
-			if (it->stripID > 2)
-			std::cout << it->stripID << std::endl;
-		}
 	}
         // deallocate input segments (to save memory!)
         // use the swap to local var trick!
@@ -764,6 +1070,7 @@ void createStrips( vector< halfsegment> & region, vector<double> &isoBounds,
 		}
 		prevVal = stripStopIndex[i];
 	}
+	
 #ifdef DEBUG_PRINT
 #pragma omp critical
 	{
@@ -940,3 +1247,250 @@ void createFinalOverlay( vector<halfsegment> & finalResult,
 }
 
 
+void indexStripBoundaries( const vector<halfsegment> &strip, const double leftBound,
+													 const double rightBound, stripBoundaryIndex &index )
+{
+	index.rightEnds.clear();
+	index.leftStarts.clear();
+	for( int j = 0; j < strip.size(); j++ ) {
+		const halfsegment &h = strip[j];
+		if( !h.isLeft() ) {
+			continue;
+		}
+		// only the first seg (halfsegment order) starting at a point is recorded
+		if( h.dx == leftBound ) {
+			index.leftStarts.insert( make_pair( h.dy, j ) );
+		}
+		if( h.sx == rightBound ) {
+			auto it = index.rightEnds.find( h.sy );
+			if( it == index.rightEnds.end() ) {
+				index.rightEnds.insert( make_pair( h.sy, make_pair( 1, j ) ) );
+			}
+			else {
+				it->second.first++;
+			}
+		}
+	}
+}
+
+void linkStripPieces( const stripBoundaryIndex &left, const stripBoundaryIndex &right,
+											vector< pair<int,int> > &links, unordered_map<int,int> &nextPiece )
+{
+	for( auto it = left.rightEnds.begin(); it != left.rightEnds.end(); it++ ) {
+		// multiple segs cross here.  The chain ends at this point
+		if( it->second.first > 1 ) {
+			continue;
+		}
+		// find the seg in the next strip
+		auto next = right.leftStarts.find( it->first );
+		if( next != right.leftStarts.end() ) {
+			links.push_back( make_pair( it->second.second, next->second ) );
+			nextPiece[ it->second.second ] = next->second;
+		}
+	}
+}
+
+void parallelCreateFinalOverlay( vector<halfsegment> & finalResult,
+																 const StripedOverlayResult &striped, executor &exec )
+{
+	const vector< vector<halfsegment> > &resultStrips = striped.resultStrips;
+	const vector< unordered_map<int,int> > &nextPiece = striped.nextPiece;
+	const vector< unordered_set<int> > &continuesChain = striped.continuesChain;
+	int numStrips = resultStrips.size();
+	vector< int > chainStarts( numStrips, 0 );
+	vector< int > stripOffset( numStrips+1, 0 );
+	// count the chain starts in each strip, then compute the output offsets
+	exec.parallelFor( numStrips, [&] (int i) {
+		traceScope trace( "count chain starts", "strip", i );
+		for( int j = 0; j < resultStrips[i].size(); j++ ) {
+			const halfsegment &h = resultStrips[i][j];
+			if( h.isLeft() && h.la != h.lb ) {
+				chainStarts[i]++;
+			}
+		}
+		// pieces continuing a chain do not start one
+		for( auto it = continuesChain[i].begin(); it != continuesChain[i].end(); it++ ) {
+			const halfsegment &h = resultStrips[i][ *it ];
+			if( h.la != h.lb ) {
+				chainStarts[i]--;
+			}
+		}
+	});
+	for( int i = 0; i < numStrips; i++ ) {
+		stripOffset[i+1] = stripOffset[i] + 2*chainStarts[i];
+	}
+	finalResult.resize( stripOffset[numStrips] );
+
+	// follow the chains and write the joined segs and their brothers
+	exec.parallelFor( numStrips, [&] (int i) {
+		traceScope trace( "stitch chains", "strip", i );
+		int writePos = stripOffset[i];
+		// no fragments cross into or out of this strip, copy it
+		if( nextPiece[i].empty() && continuesChain[i].empty() ) {
+			for( int j = 0; j < resultStrips[i].size(); j++ ) {
+				const halfsegment &h = resultStrips[i][j];
+				if( h.isLeft() && h.la != h.lb ) {
+					finalResult[ writePos++ ] = h;
+					finalResult[ writePos++ ] = h.getBrother();
+				}
+			}
+		}
+		else {
+			for( int j = 0; j < resultStrips[i].size(); j++ ) {
+				if( !striped.startsChain( i, j ) ) {
+					continue;
+				}
+				halfsegment curr = striped.stitch( i, j );
+				finalResult[ writePos++ ] = curr;
+				finalResult[ writePos++ ] = curr.getBrother();
+			}
+		}
+	});
+}
+
+void sweepStrip( executor &exec, stripWork *work, int maxStripSize, bool collectStats, 
+								 vector< sweptStrip* > &swept )
+{
+	stripWork *right = NULL;
+	if( work->r1Size + work->r2Size > maxStripSize ) {
+		traceScope trace( "split strip", "segs", work->r1Size + work->r2Size );
+		right = splitStrip( *work );
+	}
+	if( right != NULL ) {
+		// sweep the halves as a nested loop, so an idle thread can steal one
+		stripWork *halves[] = { work, right };
+		vector< sweptStrip* > halfSwept[2];
+		exec.parallelFor( 2, [&] (int h) {
+			sweepStrip( exec, halves[h], maxStripSize, collectStats, halfSwept[h] );
+		});
+		// stitch across the new bound
+		traceScope trace( "link strips", "x", halfSwept[1].front()->leftBound );
+		sweptStrip *left = halfSwept[0].back();
+		linkStripPieces( left->index, halfSwept[1].front()->index, left->links, left->nextPiece );
+		swept.insert( swept.end(), halfSwept[0].begin(), halfSwept[0].end() );
+		swept.insert( swept.end(), halfSwept[1].begin(), halfSwept[1].end() );
+		return;
+	}
+	traceScope trace( "sweep strip", "leftBound", work->leftBound, "segs", work->r1Size + work->r2Size );
+	sweptStrip *done = new sweptStrip;
+	done->leftBound = work->leftBound;
+	done->rightBound = work->rightBound;
+	if( collectStats ) {
+		StripStats &stats = done->stats;
+		stats.leftBound = work->leftBound;
+		stats.rightBound = work->rightBound;
+		stats.r1Segs = work->r1Size;
+		stats.r2Segs = work->r2Size;
+		const halfsegment *regions[] = { work->r1, work->r2 };
+		int sizes[] = { work->r1Size, work->r2Size };
+		for( int r = 0; r < 2; r++ ) {
+			for( int j = 0; j < sizes[r]; j++ ) {
+				const halfsegment &h = regions[r][j];
+				if( h.isLeft() && ( h.dx == work->leftBound || h.sx == work->rightBound ) ) {
+					stats.splitPieces++;
+				}
+			}
+		}
+		stats.worker = exec.workerIndex();
+#ifdef SWEEP_COUNTERS
+		// the sweep runs start to finish on this thread, so its counters are the difference
+		stats.counters.add( threadSweepCounters, -1 );
+#endif
+		std::chrono::time_point<std::chrono::system_clock> sweep_start = std::chrono::system_clock::now();
+		overlayPlaneSweep( work->r1, work->r1Size, work->r2, work->r2Size, done->result, &stats );
+		std::chrono::duration<double> sweep_duration = std::chrono::system_clock::now() - sweep_start;
+#ifdef SWEEP_COUNTERS
+		stats.counters.add( threadSweepCounters );
+		stats.counters.enabled = true;
+#endif
+		stats.sweepTime = sweep_duration.count();
+		stats.resultSegs = done->result.size();
+	}
+	else {
+		overlayPlaneSweep( work->r1, work->r1Size, work->r2, work->r2Size, done->result );
+	}
+	delete work;
+	indexStripBoundaries( done->result, done->leftBound, done->rightBound, done->index );
+	swept.push_back( done );
+}
+
+stripWork * splitStrip( stripWork &work )
+{
+	const halfsegment *larger = work.r1;
+	int largerSize = work.r1Size;
+	if( work.r2Size > work.r1Size ) {
+		larger = work.r2;
+		largerSize = work.r2Size;
+	}
+	if( largerSize == 0 ) {
+		return NULL;
+	}
+	// median dominating x value, and the next endpoint to the right of it in either region.
+	// Every endpoint in the strip is the dominating point of some hseg, and hsegs are sorted by dx
+	double medianX = larger[ largerSize/2 ].dx;
+	double nextX = work.rightBound;
+	const halfsegment *regions[] = { work.r1, work.r2 };
+	int sizes[] = { work.r1Size, work.r2Size };
+	for( int i = 0; i < 2; i++ ) {
+		const halfsegment *it = std::upper_bound( regions[i], regions[i]+sizes[i], medianX,
+																							[] ( double x, const halfsegment &h ) { return x < h.dx; } );
+		if( it != regions[i]+sizes[i] && it->dx < nextX ) {
+			nextX = it->dx;
+		}
+	}
+	double x = ( medianX + nextX ) / 2.0;
+	// no double between the two endpoints, or the bound would not split anything
+	if( !( medianX < x && x < nextX ) || x <= work.leftBound || x >= work.rightBound ) {
+		return NULL;
+	}
+	stripWork *right = new stripWork;
+	right->leftBound = x;
+	right->rightBound = work.rightBound;
+	work.rightBound = x;
+	vector<halfsegment> left1, left2;
+	splitRegionAt( work.r1, work.r1Size, x, left1, right->r1Pieces );
+	splitRegionAt( work.r2, work.r2Size, x, left2, right->r2Pieces );
+	work.r1Pieces.swap( left1 );
+	work.r2Pieces.swap( left2 );
+	work.r1 = work.r1Pieces.data();
+	work.r1Size = work.r1Pieces.size();
+	work.r2 = work.r2Pieces.data();
+	work.r2Size = work.r2Pieces.size();
+	right->r1 = right->r1Pieces.data();
+	right->r1Size = right->r1Pieces.size();
+	right->r2 = right->r2Pieces.data();
+	right->r2Size = right->r2Pieces.size();
+	return right;
+}
+
+void splitRegionAt( const halfsegment *pieces, int size, double x, 
+										vector<halfsegment> &left, vector<halfsegment> &right )
+{
+	for( int i = 0; i < size; i++ ) {
+		// only need to worry about lefties
+		if( !pieces[i].isLeft() ) {
+			continue;
+		}
+		halfsegment workSeg = pieces[i];
+		if( workSeg.sx < x ) {
+			left.push_back( workSeg );
+			left.push_back( workSeg.getBrother() );
+		}
+		else if( workSeg.dx > x ) {
+			right.push_back( workSeg );
+			right.push_back( workSeg.getBrother() );
+		}
+		// we cross the new bound, split the seg at x
+		else {
+			halfsegment lhs = workSeg;
+			lhs.sy = workSeg.dy = workSeg.getYvalAtX( x );
+			lhs.sx = workSeg.dx = x;
+			left.push_back( lhs );
+			left.push_back( lhs.getBrother() );
+			right.push_back( workSeg );
+			right.push_back( workSeg.getBrother() );
+		}
+	}
+	std::sort( left.begin(), left.end() );
+	std::sort( right.begin(), right.end() );
+}
@@ -11,10 +11,15 @@
 
 
 #include "halfsegment.h"
+#include "sweepCounters.h"
 #include <vector>
 #include <chrono>
 #include <iostream>
 #include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <iterator>
+#include <future>
 
 #ifndef PARSESWEEP_H
 #define PARSESWEEP_H
@@ -33,21 +38,430 @@ using namespace std;
 
 //#define DEBUG_PRINT
 
+/**
+ *  The parallel frameworks parallelOverlay() can run on.  BACKEND_DEFAULT reads the 
+ *  PPS_BACKEND environment variable (omp, tbb, c17 or pool) and falls back to BACKEND_OMP.
+ */
+enum overlayBackend {
+	BACKEND_DEFAULT = -1,
+	BACKEND_OMP,  ///< OpenMP
+	BACKEND_TBB,  ///< Intel TBB
+	BACKEND_C17,  ///< C++17 parallel algorithms
+	BACKEND_POOL  ///< a work stealing thread pool that also splits heavy strips
+};
+
+/**
+ * \struct StripStats
+ *
+ * \brief what it took to sweep one strip.  Collected only when stats are requested.
+ */
+struct StripStats {
+	double leftBound, rightBound;  ///< the strip's iso bounds
+	int r1Segs;              ///< input halfsegments from region 1
+	int r2Segs;              ///< input halfsegments from region 2
+	int splitPieces;         ///< input halfsegments that are pieces of a halfsegment split at one of the strip's iso bounds
+	int intersections;       ///< intersections found by the sweep (pairs of halfsegments broken up)
+	int peakActiveList;      ///< the most halfsegments in the active list at once
+	int peakEventQueue;      ///< the most halfsegments in the discovered event queue at once
+	int resultSegs;          ///< halfsegments in the strip's result
+	double sweepTime;        ///< wall time of the sweep in seconds
+	int worker;              ///< the backend's index of the thread that swept the strip, -1 for the calling thread helping out on the pool backend
+	sweepCounters counters;  ///< what the sweep did, when built with SWEEP_COUNTERS
+
+	StripStats( ) : leftBound( 0 ), rightBound( 0 ), r1Segs( 0 ), r2Segs( 0 ), splitPieces( 0 ), 
+									intersections( 0 ), peakActiveList( 0 ), peakEventQueue( 0 ), resultSegs( 0 ), 
+									sweepTime( 0 ), worker( -1 ) { }
+};
+
+/**
+ * \struct PhasePerf
+ *
+ * \brief hardware counters of one thread over one phase of an overlay.  Collected only when
+ *  stats are requested and perf_event_open() works, see perfProbe.h
+ */
+struct PhasePerf {
+	string phase;            ///< bounds, strips, sweep or recombine
+	int worker;              ///< the backend's index of the thread, -1 for the calling thread helping out on the pool backend
+	long long cycles;        ///< cpu cycles
+	long long instructions;  ///< instructions retired
+	long long l1dMisses;     ///< L1 data cache read misses, -1 if the cpu does not count them
+	long long llcMisses;     ///< last level cache misses, -1 if the cpu does not count them
+	long long branchMisses;  ///< mispredicted branches, -1 if the cpu does not count them
+
+	PhasePerf( ) : worker( -1 ), cycles( 0 ), instructions( 0 ), l1dMisses( 0 ), llcMisses( 0 ), 
+								 branchMisses( 0 ) { }
+};
+
+/**
+ * \struct PhaseMemory
+ *
+ * \brief allocations and resident memory of the whole process over one phase, see memProbe.h.
+ *  Collected only when stats are requested
+ */
+struct PhaseMemory {
+	string phase;              ///< load, sort, bounds, strips, sweep or recombine
+	long long allocations;     ///< calls to operator new, -1 unless built with MEM_ACCOUNTING
+	long long frees;           ///< calls to operator delete, -1 unless built with MEM_ACCOUNTING
+	long long bytesAllocated;  ///< bytes handed out by operator new, -1 unless built with MEM_ACCOUNTING
+	long long bytesFreed;      ///< bytes returned to operator delete, -1 unless built with MEM_ACCOUNTING
+	long long rssStart;        ///< resident bytes when the phase started, -1 if /proc is not available
+	long long rssEnd;          ///< resident bytes when the phase ended, -1 if /proc is not available
+	long long peakRss;         ///< the most resident bytes during the phase, -1 if /proc is not available
+
+	PhaseMemory( ) : allocations( -1 ), frees( -1 ), bytesAllocated( -1 ), bytesFreed( -1 ), 
+									 rssStart( -1 ), rssEnd( -1 ), peakRss( -1 ) { }
+};
+
+/**
+ * \struct OverlayStats
+ *
+ * \brief wall times (in seconds) and sizes of one parallelOverlay() call.
+ *
+ *  Pass one to parallelOverlay() to have it filled in.  Nothing is written to disk by the 
+ *  library, main.cpp writes the stats as csv or json.
+ */
+struct OverlayStats {
+	string backend;          ///< the backend the overlay ran on: orig (OpenMP), tbb, c17 or pool
+	double findBoundsTime;   ///< placing the iso bounds
+	double r1StripsTime;     ///< splitting region 1 into strips.  Runs next to r2StripsTime
+	double r2StripsTime;     ///< splitting region 2 into strips
+	double sweepTime;        ///< sweeping (and linking) all strips
+	double recombineTime;    ///< marking the chains and, unless the result is striped, stitching them
+	int requestedStrips;     ///< strips asked for, before any heavy strip is split.  Does not vary between runs
+	int numStrips;           ///< strips swept, including strips created by splitting a heavy strip
+	long long r1Segs;        ///< input halfsegments in region 1
+	long long r2Segs;        ///< input halfsegments in region 2
+	long long r1StripSegs;   ///< halfsegments of region 1 after splitting them at the iso bounds
+	long long r2StripSegs;   ///< halfsegments of region 2 after splitting them at the iso bounds
+	long long resultSegs;    ///< halfsegments in the result, before stitching for a striped result
+	vector< StripStats > strips;  ///< one entry per swept strip, in x order
+	sweepCounters counters;  ///< the strips' counters summed, when built with SWEEP_COUNTERS
+	vector< PhasePerf > perf;     ///< hardware counters per phase and thread, empty if perf_event_open() is not available
+	vector< PhaseMemory > memory; ///< allocations and resident memory of the bounds, strips, sweep and recombine phases
+
+	OverlayStats( ) : findBoundsTime( 0 ), r1StripsTime( 0 ), r2StripsTime( 0 ), sweepTime( 0 ),
+										recombineTime( 0 ), requestedStrips( 0 ), numStrips( 0 ), r1Segs( 0 ), r2Segs( 0 ), 
+										r1StripSegs( 0 ), r2StripSegs( 0 ), resultSegs( 0 ) { }
+};
+
+class executor;
+
+/**
+ * \class OverlayContext
+ *
+ * \brief owns the worker threads parallelOverlay() runs on, so they are reused across calls.
+ *
+ *  The versions of parallelOverlay() that do not take a context start the backend's threads
+ *  on every call, which dominates when overlaying many small region pairs.  Create one context
+ *  with a fixed thread count and pass it to every call instead.  Several threads may run 
+ *  parallelOverlay() on the same context at once.
+ *
+ *  On a NUMA machine, a context with pinned threads also keeps each strip on the node of the
+ *  thread sweeping it, see placesStripsLocally().
+ */
+class OverlayContext {
+public:
+	/**
+	 *  \param numWorkerThreads the number of worker threads.  Values < 1 use the backend's default.
+	 *  \param backend the parallel framework to run on, see overlayBackend
+	 *  \param pinThreads pin worker i to the i-th CPU this process may run on.  The thread that 
+	 *                    calls parallelOverlay() is pinned as well on the omp and tbb backends, 
+	 *                    since it takes part in the loops.  The c17 backend can not pin.
+	 */
+	explicit OverlayContext( int numWorkerThreads = -1, overlayBackend backend = BACKEND_DEFAULT, 
+													 bool pinThreads = false );
+	~OverlayContext( );
+
+	/// the number of threads loops run on
+	unsigned int concurrency( ) const;
+
+	/**
+	 *  True if each strip is copied into buffers first touched by the thread that sweeps it, so
+	 *  the sweep reads and writes memory on that thread's NUMA node.  Only done when the threads
+	 *  are pinned and there is more than one node, otherwise the copy buys nothing.
+	 */
+	bool placesStripsLocally( ) const {
+		return localStrips;
+	}
+
+	/**
+	 *  The fraction of pages allocated on a remote NUMA node, system wide, since the context 
+	 *  was created.  Returns -1 if the platform does not expose the counters.
+	 */
+	double remoteAllocationRatio( ) const;
+
+	/// the backend all loops of this context run on
+	executor & getExecutor( ) {
+		return *exec;
+	}
+
+private:
+	OverlayContext( const OverlayContext & );
+	OverlayContext & operator=( const OverlayContext & );
+
+	executor *exec;
+	bool localStrips;
+	/// system wide NUMA allocation counters when the context was created, -1 if not available
+	long long startLocalPages, startRemotePages;
+};
+
+
+
+
+/**
+ * \class StripedOverlayResult
+ *
+ * \brief the result of an overlay left in the strips it was computed in.
+ *
+ *  Holds the swept strips, the iso bounds, and the links between the pieces of halfsegments 
+ *  that were split at an iso bound.  Nothing is copied or stitched up front.  strip() gives the
+ *  raw pieces of a strip, which is all that callers such as area totals or label filters need.
+ *  begin()/end() walk the stitched overlay, joining pieces on demand, in the same order as the 
+ *  vector<halfsegment> version of parallelOverlay() produces it.
+ */
+struct StripedOverlayResult {
+	/// the result of sweeping each strip, in halfsegment order
+	vector< vector<halfsegment> > resultStrips;
+	/// the strip boundaries
+	vector< double > isoBounds;
+	/// for each strip, (index in the strip, index in the next strip) pairs of joined pieces
+	vector< vector< pair<int,int> > > links;
+	/// for each strip, index in the strip -> index in the next strip of joined pieces
+	vector< unordered_map<int,int> > nextPiece;
+	/// for each strip, the indexes of pieces that continue a halfsegment from an earlier strip
+	vector< unordered_set<int> > continuesChain;
+
+	/**
+	 *  Remove all strips
+	 */
+	void clear( ) {
+		resultStrips.clear();
+		isoBounds.clear();
+		links.clear();
+		nextPiece.clear();
+		continuesChain.clear();
+	}
+
+	/**
+	 *  The number of strips
+	 */
+	int numStrips( ) const {
+		return resultStrips.size();
+	}
+
+	/**
+	 *  The pieces of strip i, in halfsegment order.  Halfsegments crossing an iso bound are split there.
+	 */
+	const vector<halfsegment> & strip( int i ) const {
+		return resultStrips[i];
+	}
+
+	/**
+	 *  Mark the pieces that continue a halfsegment started in an earlier strip.  A piece continues
+	 *  a halfsegment if the piece linking to it starts one (valid left hseg) or continues one itself.
+	 *  Must be called once all strips are linked, before stitching.
+	 */
+	void markChains( ) {
+		continuesChain.assign( resultStrips.size(), unordered_set<int>() );
+		for( int i = 0; i+1 < resultStrips.size(); i++ ) {
+			for( int k = 0; k < links[i].size(); k++ ) {
+				const halfsegment &h = resultStrips[i][ links[i][k].first ];
+				if( continuesChain[i].count( links[i][k].first ) || h.la != h.lb ) {
+					continuesChain[i+1].insert( links[i][k].second );
+				}
+			}
+		}
+	}
 
+	/**
+	 *  Returns true if piece index of strip stripID is the first piece of a stitched halfsegment
+	 */
+	bool startsChain( int stripID, int index ) const {
+		const halfsegment &h = resultStrips[stripID][index];
+		return h.isLeft() && h.la != h.lb && !continuesChain[stripID].count( index );
+	}
 
+	/**
+	 *  Join the pieces starting at piece index of strip stripID.  Returns the stitched left halfsegment.
+	 */
+	halfsegment stitch( int stripID, int index ) const {
+		halfsegment curr = resultStrips[stripID][index];
+		unordered_map<int,int>::const_iterator next;
+		while( (next = nextPiece[stripID].find( index )) != nextPiece[stripID].end() ) {
+			index = next->second;
+			stripID++;
+		}
+		// update curr with the last segs sub point
+		curr.sx = resultStrips[stripID][index].sx;
+		curr.sy = resultStrips[stripID][index].sy;
+		return curr;
+	}
+
+	/**
+	 *  Forward iterator over the stitched overlay.  Each stitched left halfsegment is followed by its brother.
+	 */
+	class const_iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category;
+		typedef halfsegment value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const halfsegment* pointer;
+		typedef const halfsegment& reference;
+
+		const_iterator( const StripedOverlayResult *owner, int stripID, int index ) :
+			owner( owner ), stripID( stripID ), index( index ), brother( false )
+		{
+			findChainStart();
+		}
+		reference operator*( ) const { return curr; }
+		pointer operator->( ) const { return &curr; }
+		const_iterator & operator++( ) {
+			if( !brother ) {
+				brother = true;
+				curr = curr.getBrother();
+			}
+			else {
+				brother = false;
+				index++;
+				findChainStart();
+			}
+			return *this;
+		}
+		const_iterator operator++( int ) {
+			const_iterator tmp( *this );
+			++(*this);
+			return tmp;
+		}
+		bool operator==( const const_iterator &rhs ) const {
+			return stripID == rhs.stripID && index == rhs.index && brother == rhs.brother;
+		}
+		bool operator!=( const const_iterator &rhs ) const {
+			return !(*this == rhs);
+		}
+	private:
+		/// move forward to the next piece that starts a stitched halfsegment, and stitch it
+		void findChainStart( ) {
+			while( stripID < owner->numStrips() ) {
+				for( ; index < owner->resultStrips[stripID].size(); index++ ) {
+					if( owner->startsChain( stripID, index ) ) {
+						curr = owner->stitch( stripID, index );
+						return;
+					}
+				}
+				stripID++;
+				index = 0;
+			}
+		}
+		const StripedOverlayResult *owner;
+		int stripID, index;
+		bool brother;
+		halfsegment curr;
+	};
+
+	const_iterator begin( ) const {
+		return const_iterator( this, 0, 0 );
+	}
+	const_iterator end( ) const {
+		return const_iterator( this, numStrips(), 0 );
+	}
+};
 
 /**
  *  Compute the overlay of two regions in parallel.  This is a wrapper function that divides a pair
  *  of input regions into strips, assigns halfsegments to the appropriate strips, then calls a plane
  *  sweep algorithm on each strip.  
  *
+ *  On the pool backend with more than one thread, strips that are much heavier than the
+ *  others are split again while they are swept.  The extra iso bounds change the result like 
+ *  a higher strip count would, so such runs are not bit-identical to runs without splitting.
+ *
  *  \param r1 [in/out] input region 1
  *  \param r2 [in/out] input region 2
  *  \param numSplits how many strips should be created over the input. If no value is given, the number of strips defaults to the number of processor cores.
- * \param numWorkerThreads The number of worker threads for openMP to use.  If no value is given, openMP's default value is used.
+ * \param numWorkerThreads The number of worker threads to use.  If no value is given, the backend's default value is used.
+ * \param backend the parallel framework to run on, see overlayBackend
+ * \param stats [out] if not NULL, filled in with the timings and sizes of the overlay
  */
 void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, vector<halfsegment> &result, 
-											int numSplits=-1,  int numWorkerThreads = -1);
+											int numSplits=-1,  int numWorkerThreads = -1, overlayBackend backend = BACKEND_DEFAULT,
+											OverlayStats *stats = NULL );
+
+/**
+ *  Compute the overlay of two regions in parallel, but leave the result in strips.  The pieces 
+ *  of halfsegments split at iso bounds are linked, not joined.  Callers that do not need the
+ *  stitched, sorted result skip the recombine and the copy into a single vector.
+ *
+ *  \param result [out] the overlay, see StripedOverlayResult
+ *
+ *  The other parameters are the same as for the vector<halfsegment> version.
+ */
+void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, StripedOverlayResult &result, 
+											int numSplits=-1,  int numWorkerThreads = -1, overlayBackend backend = BACKEND_DEFAULT,
+											OverlayStats *stats = NULL );
+
+/**
+ *  Compute the overlay of two regions in parallel on the threads of an existing context.
+ *
+ *  \param context the threads to run on, see OverlayContext
+ *  \param numSplits how many strips should be created over the input. If no value is given, the number of strips defaults to the context's number of threads.
+ *
+ *  The other parameters are the same as for the versions without a context.
+ */
+void parallelOverlay( OverlayContext &context, vector<halfsegment> &r1, vector<halfsegment> &r2, 
+											vector<halfsegment> &result, int numSplits=-1,
+											OverlayStats *stats = NULL );
+
+/**
+ *  Striped version of parallelOverlay() on the threads of an existing context.
+ */
+void parallelOverlay( OverlayContext &context, vector<halfsegment> &r1, vector<halfsegment> &r2, 
+											StripedOverlayResult &result, int numSplits=-1,
+											OverlayStats *stats = NULL );
+
+/**
+ *  Start an overlay on the threads of a context and return right away.  On the work stealing
+ *  backends (tbb and pool) the strips are queued on the context's threads next to the strips 
+ *  of any other overlay in flight, so many overlays keep the machine busy and a small one does
+ *  not wait for a big one to finish.  omp and c17 run a loop on a whole team of threads, so 
+ *  they queue the overlays on one extra thread that runs them one at a time, in the order they
+ *  were started, and never start more than one team.
+ *
+ *  The context, r1, r2, result and stats must stay alive, and r1, r2, result and stats must 
+ *  not be touched, until the future is ready.
+ *
+ *  \return a future that is ready when result holds the overlay.  Its get() rethrows 
+ *          anything the overlay threw.
+ *
+ *  The parameters are the same as for parallelOverlay().
+ */
+std::future<void> parallelOverlayAsync( OverlayContext &context, vector<halfsegment> &r1, 
+																				vector<halfsegment> &r2, vector<halfsegment> &result, 
+																				int numSplits=-1, OverlayStats *stats = NULL );
+
+/**
+ *  Striped version of parallelOverlayAsync().
+ */
+std::future<void> parallelOverlayAsync( OverlayContext &context, vector<halfsegment> &r1, 
+																				vector<halfsegment> &r2, StripedOverlayResult &result, 
+																				int numSplits=-1, OverlayStats *stats = NULL );
+
+/// pairs with fewer halfsegments than this are swept serially by overlayBatch()
+const int BATCH_MIN_STRIPED_SIZE = 16384;
+
+/**
+ *  Compute the overlays of many region pairs on the threads of a context, for throughput.
+ *  Splitting a small pair into strips costs more than it saves, so pairs with fewer than 
+ *  minStripedSize halfsegments are swept serially with overlayPlaneSweep(), many pairs at a 
+ *  time.  Larger pairs go through the strip path of parallelOverlay().  On the work stealing 
+ *  backends the large pairs' strips run next to the small pairs, otherwise the large pairs 
+ *  run one at a time first.
+ *
+ *  \param pairs [in/out] the region pairs, each region sorted like for parallelOverlay()
+ *  \param results [out] results[i] is the overlay of pairs[i]
+ *  \param minStripedSize pairs with fewer halfsegments than this are swept serially
+ */
+void overlayBatch( OverlayContext &context, vector< pair< vector<halfsegment>, vector<halfsegment> > > &pairs,
+									 vector< vector<halfsegment> > &results, int minStripedSize = BATCH_MIN_STRIPED_SIZE );
 
 
 
@@ -61,10 +475,21 @@ void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, vector<h
  *  \param r1Size the length of the r1 vector
  *  \param r2Size the length of the r2 vector
  *  \param result [in/out] the result of overlaying r1 and r2
+ *  \param stats [out] if not NULL, the intersection count and peak active list and event queue
+ *               sizes are filled in.  The other fields are left alone
  */
 void overlayPlaneSweep( const halfsegment r1[], int r1Size, 
 												const halfsegment r2[], int r2Size, 
-												vector<halfsegment>& result );
-#endif
-
+												vector<halfsegment>& result, StripStats *stats = NULL );
 
+/**
+ *  Remove breaks in halfsegments that are only introduced to create strips.
+ *  
+ *  The serial stitcher of the original code.  parallelOverlay() uses 
+ *  parallelCreateFinalOverlay() instead, this is kept as the reference stitchTest compares 
+ *  it against.  Invalidates the joined pieces in resultStrips.
+ */
+void createFinalOverlay( vector<halfsegment> & finalResult,
+												 vector< vector<halfsegment> > &resultStrips, 
+												 const vector<double> &isoBounds );
+#endif
@@ -0,0 +1,223 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+#include "perfProbe.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+#ifdef __linux__
+/**
+ * \struct threadPerfGroup
+ *
+ * \brief the calling thread's counter group.  Closed when the thread exits.
+ */
+struct threadPerfGroup {
+	static const int NUM_EVENTS = 5;
+	/// the group leader, -1 if the counters could not be opened
+	int leader;
+	/// the position of each event in the group's read() output, -1 if the event is not counted
+	int slot[ NUM_EVENTS ];
+	int numOpen;
+	int fds[ NUM_EVENTS ];
+
+	threadPerfGroup( ) : leader( -1 ), numOpen( 0 ) {
+		const unsigned int types[ NUM_EVENTS ] = { PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, 
+				PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE };
+		const unsigned long long configs[ NUM_EVENTS ] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+				PERF_COUNT_HW_CACHE_L1D | ( PERF_COUNT_HW_CACHE_OP_READ << 8 ) | ( PERF_COUNT_HW_CACHE_RESULT_MISS << 16 ),
+				PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+		for( int e = 0; e < NUM_EVENTS; e++ ) {
+			slot[e] = -1;
+			struct perf_event_attr attr;
+			memset( &attr, 0, sizeof( attr ) );
+			attr.size = sizeof( attr );
+			attr.type = types[e];
+			attr.config = configs[e];
+			attr.read_format = PERF_FORMAT_GROUP;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			// pid 0, cpu -1: this thread on any cpu
+			int fd = syscall( SYS_perf_event_open, &attr, 0, -1, leader, 0 );
+			if( fd < 0 ) {
+				// cycles and instructions are required, the rest are optional
+				if( e < 2 ) {
+					close( );
+					return;
+				}
+				continue;
+			}
+			if( leader < 0 ) {
+				leader = fd;
+			}
+			fds[ numOpen ] = fd;
+			slot[e] = numOpen++;
+		}
+	}
+
+	~threadPerfGroup( ) {
+		close( );
+	}
+
+	void close( ) {
+		for( int i = 0; i < numOpen; i++ ) {
+			::close( fds[i] );
+		}
+		numOpen = 0;
+		leader = -1;
+	}
+
+	bool read( PhasePerf &counters ) {
+		if( leader < 0 ) {
+			return false;
+		}
+		// PERF_FORMAT_GROUP: the number of events, then their values
+		unsigned long long values[ NUM_EVENTS + 1 ];
+		if( ::read( leader, values, sizeof( values ) ) < (ssize_t) sizeof( unsigned long long ) ) {
+			return false;
+		}
+		long long *fields[ NUM_EVENTS ] = { &counters.cycles, &counters.instructions, &counters.l1dMisses,
+				&counters.llcMisses, &counters.branchMisses };
+		for( int e = 0; e < NUM_EVENTS; e++ ) {
+			*fields[e] = ( slot[e] < 0 ) ? -1 : values[ 1 + slot[e] ];
+		}
+		return true;
+	}
+};
+#endif
+
+bool readThreadPerf( PhasePerf &counters )
+{
+#ifdef __linux__
+	static thread_local threadPerfGroup group;
+	return group.read( counters );
+#else
+	return false;
+#endif
+}
+
+/// add end - start to sum, leaving counters that are not counted at -1
+static void addPerfDifference( PhasePerf &sum, const PhasePerf &start, const PhasePerf &end )
+{
+	long long PhasePerf::*fields[] = { &PhasePerf::cycles, &PhasePerf::instructions, &PhasePerf::l1dMisses,
+			&PhasePerf::llcMisses, &PhasePerf::branchMisses };
+	for( int f = 0; f < 5; f++ ) {
+		if( end.*fields[f] < 0 ) {
+			sum.*fields[f] = -1;
+		}
+		else {
+			sum.*fields[f] += end.*fields[f] - start.*fields[f];
+		}
+	}
+}
+
+thread_local perfProbeExecutor::perfFrame *perfProbeExecutor::topFrame = NULL;
+
+class perfProbeExecutor::frameScope {
+public:
+	explicit frameScope( perfProbeExecutor &probe ) : probe( probe ) {
+		probe.enter( frame );
+	}
+	~frameScope( ) {
+		probe.leave( frame );
+	}
+private:
+	perfProbeExecutor &probe;
+	perfFrame frame;
+};
+
+perfProbeExecutor::perfFrame * perfProbeExecutor::countingFrame( perfFrame *frame )
+{
+	while( frame != NULL && !frame->counting ) {
+		frame = frame->outer;
+	}
+	return frame;
+}
+
+perfProbeExecutor::~perfProbeExecutor( )
+{
+	if( callerOpen ) {
+		leave( callerFrame );
+	}
+}
+
+void perfProbeExecutor::charge( const PhasePerf &start, const PhasePerf &end )
+{
+	std::lock_guard< std::mutex > guard( lock );
+	addPerfDifference( perWorker[ inner.workerIndex() ], start, end );
+}
+
+void perfProbeExecutor::enter( perfFrame &frame )
+{
+	frame.probe = this;
+	frame.outer = topFrame;
+	frame.counting = false;
+	topFrame = &frame;
+	perfFrame *running = countingFrame( frame.outer );
+	if( running != NULL && running->probe == this ) {
+		// nested in a frame of this probe, which goes on counting
+		return;
+	}
+	PhasePerf now;
+	if( !readThreadPerf( now ) ) {
+		return;
+	}
+	if( running != NULL ) {
+		running->probe->charge( running->start, now );
+	}
+	frame.start = now;
+	frame.counting = true;
+}
+
+void perfProbeExecutor::leave( perfFrame &frame )
+{
+	topFrame = frame.outer;
+	PhasePerf now;
+	if( !frame.counting || !readThreadPerf( now ) ) {
+		return;
+	}
+	charge( frame.start, now );
+	perfFrame *paused = countingFrame( frame.outer );
+	if( paused != NULL ) {
+		paused->start = now;
+	}
+}
+
+void perfProbeExecutor::parallelFor( int n, const function<void(int)> &body )
+{
+	inner.parallelFor( n, [&] (int i) {
+		frameScope scope( *this );
+		body( i );
+	});
+}
+
+void perfProbeExecutor::startPhase( const char *phase )
+{
+	this->phase = phase;
+	perWorker.clear();
+	enter( callerFrame );
+	callerOpen = true;
+}
+
+void perfProbeExecutor::stopPhase( vector< PhasePerf > &results )
+{
+	leave( callerFrame );
+	callerOpen = false;
+	for( map< int, PhasePerf >::iterator it = perWorker.begin(); it != perWorker.end(); it++ ) {
+		results.push_back( it->second );
+		results.back().phase = phase;
+		results.back().worker = it->first;
+	}
+}
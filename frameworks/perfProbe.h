@@ -0,0 +1,106 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+#include "executor.h"
+#include <mutex>
+#include <map>
+
+#ifndef PERFPROBE_H
+#define PERFPROBE_H
+
+/**
+ * \file
+ *
+ * Hardware performance counters for the phases of an overlay, read with Linux's 
+ * perf_event_open().  Each thread opens one counter group for itself the first time it is
+ * measured and keeps it open, so a measurement is a single read() of the group.  
+ *
+ * The group is scheduled as a whole, so when the PMU is shared the counts stay consistent with
+ * each other but cover only the time the group was on the cpu.
+ */
+
+/**
+ *  Read the calling thread's counters, opening them on first use.  Returns false if
+ *  perf_event_open() is not available (other platforms, no PMU, or perf_event_paranoid too 
+ *  high).
+ */
+bool readThreadPerf( PhasePerf &counters );
+
+/**
+ * \class perfProbeExecutor
+ *
+ * \brief wraps another executor and charges the counters of every loop body to the current 
+ *  phase, per thread.
+ *
+ *  Each thread keeps a stack of the measurements it has open, one frame per loop body and per
+ *  phase.  A body nested in one of the same probe counts nothing, so inline loops are not 
+ *  counted twice, and nested iterations stolen by another thread are counted on that thread.
+ *  A frame of another probe, such as an overlay a work stealing backend runs on a thread that
+ *  waits for a loop of this one, pauses the frame below it until it is done, so each probe is 
+ *  charged its own work only.  The calling thread is measured from startPhase() to stopPhase().
+ */
+class perfProbeExecutor : public executor {
+public:
+	explicit perfProbeExecutor( executor &inner ) : inner( inner ), callerOpen( false ) { }
+	/// closes the phase if stopPhase() was not reached, because the overlay threw
+	~perfProbeExecutor( );
+
+	const char * name( ) const { return inner.name(); }
+	unsigned int concurrency( ) const { return inner.concurrency(); }
+	bool stealsWork( ) const { return inner.stealsWork(); }
+	bool splitsHeavyStrips( ) const { return inner.splitsHeavyStrips(); }
+	int workerIndex( ) const { return inner.workerIndex(); }
+	std::future<void> async( const function<void()> &task ) { return inner.async( task ); }
+
+	void parallelFor( int n, const function<void(int)> &body );
+
+	/// start measuring a phase.  Phases do not overlap
+	void startPhase( const char *phase );
+
+	/// stop measuring the current phase and append one PhasePerf per thread that took part to \a results
+	void stopPhase( vector< PhasePerf > &results );
+
+private:
+	/// one open measurement of a thread
+	struct perfFrame {
+		perfProbeExecutor *probe;
+		/// the counters when the frame was entered or last resumed
+		PhasePerf start;
+		/// false if the frame counts nothing: it is nested in a counting frame of the same probe, or the counters could not be read
+		bool counting;
+		/// the frame below this one on the thread's stack
+		perfFrame *outer;
+	};
+	/// enters a frame on construction and leaves it on destruction, also when a loop body throws
+	class frameScope;
+
+	/// push a frame on the calling thread's stack, pausing the frame below if it is another probe's
+	void enter( perfFrame &frame );
+	/// pop the calling thread's top frame, charge it to the thread and resume the frame below
+	void leave( perfFrame &frame );
+	/// add end - start to the calling thread's counters
+	void charge( const PhasePerf &start, const PhasePerf &end );
+	/// the innermost frame at or below \a frame that counts, NULL if there is none
+	static perfFrame * countingFrame( perfFrame *frame );
+
+	executor &inner;
+	string phase;
+	perfFrame callerFrame;
+	/// true from startPhase() to stopPhase()
+	bool callerOpen;
+	std::mutex lock;
+	map< int, PhasePerf > perWorker;
+	/// the calling thread's innermost frame, NULL if it has none
+	static thread_local perfFrame *topFrame;
+};
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include "halfsegment.h"
+#include "d2hex.h"
+
+#ifndef REGIONFILE_H
+#define REGIONFILE_H
+
+/**
+ * Function that tokenizes a string.  
+ * @param [in] str: the string to tokenize
+ * @param [out] tokens: a vecotr of string tokens
+ * @param [in] delimiters:  A string consisting of delimiters on which to tokenize
+ */
+inline void tokenizeString(const std::string& str, std::vector<string>& tokens, const string& delimiters )
+{
+    std::string::size_type lastPos = str.find_first_not_of(delimiters, 0);	// Skip delimiters at beginning.
+    std::string::size_type pos     = str.find_first_of(delimiters, lastPos);	// Find first "non-delimiter".
+
+    while (std::string::npos != pos || std::string::npos != lastPos)
+    {
+        tokens.push_back(str.substr(lastPos, pos - lastPos));	        // Found a token, add it to the vector.
+        lastPos = str.find_first_not_of(delimiters, pos);		// Skip delimiters.  Note the "not_of"
+        pos = str.find_first_of(delimiters, lastPos);			// Find next "non-delimiter"
+    }
+}
+
+/**
+ * Read a region from a file in the hexadecimal format.  Each line holds a segment: the hex
+ * coordinates dx dy sx sy, then the labels above and below.  Empty lines and lines starting 
+ * with # are skipped.  Each segment adds its halfsegment and its brother.  The halfsegments 
+ * are not sorted.
+ *
+ * @param [in] fileName: the file to read
+ * @param [in] regionID: the region ID to give each halfsegment
+ * @param [out] region: the halfsegments are appended to it
+ * @return false if the file could not be opened
+ */
+inline bool readHexRegion( const char* fileName, int regionID, vector< halfsegment >& region )
+{
+    ifstream inFileStrm;
+    inFileStrm.open( fileName );
+    if( ! inFileStrm )
+    {
+        return false;
+    }
+    vector<string> splitLine;
+    string line("  ");
+    int la, lb;
+    while(inFileStrm.good() )
+    {
+        getline(inFileStrm, line);
+        if( inFileStrm.good() )
+        {
+            if( line.size() == 0 || line[0] == '#' )
+                continue;
+            splitLine.clear();
+            string delim(" \t" );
+            tokenizeString( line, splitLine, delim );
+            halfsegment h;
+            h.dx = doubleHexConverter::hex2d(splitLine[0]);
+            h.dy = doubleHexConverter::hex2d(splitLine[1]);
+            h.sx = doubleHexConverter::hex2d(splitLine[2]);
+            h.sy = doubleHexConverter::hex2d(splitLine[3]);
+            stringstream ss1( splitLine[4] );
+            ss1 >> la;
+            stringstream ss2( splitLine[5] );
+            ss2 >> lb;
+            h.la = la;
+            h.ola = la;
+            h.lb = lb;
+            h.olb = lb;
+            h.regionID = regionID;
+            region.push_back( h );
+            region.push_back( h.getBrother() );
+        }
+    }
+    return true;
+}
+
+#endif
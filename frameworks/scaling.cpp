@@ -0,0 +1,248 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "parPlaneSweep.h"
+#include "executor.h"
+#include "regionFile.h"
+#include "generatedRegions.h"
+#include <fstream>
+using namespace std;
+
+/// the phases reported, in the order of OverlayStats
+const int NUM_PHASES = 5;
+const char * const PHASE_NAMES[ NUM_PHASES ] = { "total", "bounds", "strips", "sweep", "recombine" };
+
+/**
+ * The median timings of one thread count
+ */
+struct scalingPoint {
+    string backend;               ///< the backend's label
+    int threads;
+    int strips;
+    long long segs;               ///< halfsegments in both inputs
+    double phase[ NUM_PHASES ];   ///< median seconds of each phase
+};
+
+/**
+ * The median of a sample
+ */
+double median( vector< double > sample )
+{
+    std::sort( sample.begin(), sample.end() );
+    int n = sample.size();
+    return ( n % 2 ) ? sample[n/2] : ( sample[n/2-1] + sample[n/2] ) / 2;
+}
+
+/**
+ * Time the overlay at one thread count
+ * @param [in] backend: the backend to run on
+ * @param [in] threads: the number of worker threads
+ * @param [in] strips: the number of strips
+ * @param [in] warmups, reps: untimed and timed runs
+ * @param [in] v1, v2: the sorted regions
+ * @return the median time of each phase
+ */
+scalingPoint measure( overlayBackend backend, int threads, int strips, int warmups, int reps,
+                      vector< halfsegment >& v1, vector< halfsegment >& v2 )
+{
+    OverlayContext context( threads, backend );
+    vector< halfsegment > result;
+    vector< double > times[ NUM_PHASES ];
+    for( int i = 0; i < warmups + reps; i++ ) {
+        OverlayStats stats;
+        std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+        parallelOverlay( context, v1, v2, result, strips, &stats );
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if( i < warmups ) {
+            continue;
+        }
+        times[0].push_back( elapsed.count() );
+        times[1].push_back( stats.findBoundsTime );
+        // both regions are split at once, the longer one is the phase's critical path
+        times[2].push_back( std::max( stats.r1StripsTime, stats.r2StripsTime ) );
+        times[3].push_back( stats.sweepTime );
+        times[4].push_back( stats.recombineTime );
+    }
+    scalingPoint p;
+    p.backend = context.getExecutor().name();
+    p.threads = threads;
+    p.strips = strips;
+    p.segs = v1.size() + v2.size();
+    for( int f = 0; f < NUM_PHASES; f++ ) {
+        p.phase[f] = median( times[f] );
+    }
+    return p;
+}
+
+/**
+ * Measures how the overlay scales with the number of worker threads, and the parallel 
+ * efficiency of each phase.
+ *
+ * Strong scaling overlays the same input at every thread count, the efficiency at p threads 
+ * is T(1) / (p T(p)).  Weak scaling generates an input that grows with the thread count, the
+ * efficiency is T(1) / T(p).
+ *
+ * The command line arguments required are one of:
+ *  - strong [an input hex file with region 1] [an input hex file with region 2]
+ *  - weak [the number of segments per region per thread]
+ *
+ * Optional arguments, in any order after those:
+ *  - -b [backend]: omp, tbb, c17 or pool (default PPS_BACKEND, or omp)
+ *  - -t [thread counts]: comma separated (default powers of two up to the number of cpus)
+ *  - -s [strips]: a fixed number of strips, or a number followed by x for that many strips per
+ *    thread (default 4x)
+ *  - -r [timed runs per thread count] (default 5)
+ *  - -w [warm up runs per thread count] (default 1)
+ *  - -d, -l, -c, -v, -seed: the generator's knobs for weak scaling, see regionGen
+ *  - -o [csv file]: also append one row per thread count to this file
+ */
+int main( int argc, char * argv[] )
+{
+    string mode = ( argc > 1 ) ? argv[1] : "";
+    int firstOption = ( mode == "strong" ) ? 4 : 3;
+    if( ( mode != "strong" && mode != "weak" ) || argc < firstOption || ( argc - firstOption ) % 2 != 0 )
+    {
+        std::cerr << "usage: scaling strong [input file name 1] [input file name 2] [options]" << std::endl;
+        std::cerr << "       scaling weak [segments per thread] [options]" << std::endl;
+        std::cerr << "options: [-b backend] [-t threads] [-s strips|Nx] [-r runs] [-w warmups] [-d density] [-l colinear] [-c clustering] [-v vertical] [-seed seed] [-o csv]" << std::endl;
+        exit( -1 );
+    }
+    overlayBackend backend = BACKEND_DEFAULT;
+    vector< int > threadCounts;
+    int numCpus = std::max( 1u, std::thread::hardware_concurrency() );
+    for( int t = 1; t < numCpus; t *= 2 ) {
+        threadCounts.push_back( t );
+    }
+    threadCounts.push_back( numCpus );
+    int strips = 4;
+    bool stripsPerThread = true;
+    int reps = 5, warmups = 1;
+    genOptions genOpts;
+    string csvFileName;
+    for( int i = firstOption; i < argc; i += 2 ) {
+        string flag( argv[i] );
+        string value( argv[i+1] );
+        if( flag == "-b" ) {
+            backend = backendFromName( value );
+            if( backend == BACKEND_DEFAULT ) {
+                cerr << "unknown backend: " << value << ", use omp, tbb, c17 or pool" << endl;
+                exit( -1 );
+            }
+        }
+        else if( flag == "-t" ) {
+            vector< string > tokens;
+            tokenizeString( value, tokens, "," );
+            threadCounts.clear();
+            for( int k = 0; k < tokens.size(); k++ ) {
+                threadCounts.push_back( atoi( tokens[k].c_str() ) );
+            }
+        }
+        else if( flag == "-s" ) {
+            stripsPerThread = !value.empty() && value[ value.size()-1 ] == 'x';
+            strips = atoi( value.c_str() );
+        }
+        else if( flag == "-r" ) reps = std::max( 1, atoi( value.c_str() ) );
+        else if( flag == "-w" ) warmups = atoi( value.c_str() );
+        else if( flag == "-d" ) genOpts.density = atof( value.c_str() );
+        else if( flag == "-l" ) genOpts.colinear = atof( value.c_str() );
+        else if( flag == "-c" ) genOpts.clustering = atof( value.c_str() );
+        else if( flag == "-v" ) genOpts.vertical = atof( value.c_str() );
+        else if( flag == "-seed" ) genOpts.seed = atoi( value.c_str() );
+        else if( flag == "-o" ) csvFileName = value;
+        else {
+            std::cerr << "unknown option: " << flag << std::endl;
+            exit( -1 );
+        }
+    }
+
+    vector< halfsegment > v1, v2;
+    long long segsPerThread = 0;
+    if( mode == "strong" ) {
+        if( !readHexRegion( argv[2], 2, v1 ) || !readHexRegion( argv[3], 3, v2 ) )
+        {
+            cerr << "Error: could not open file: " << argv[2] << " or " << argv[3] << endl;
+            exit( -1 );
+        }
+        std::sort( v1.begin(), v1.end() );
+        std::sort( v2.begin(), v2.end() );
+    }
+    else {
+        segsPerThread = atoll( argv[2] );
+    }
+
+    vector< scalingPoint > points;
+    for( int t = 0; t < threadCounts.size(); t++ ) {
+        int threads = threadCounts[t];
+        if( mode == "weak" ) {
+            genOpts.segments = segsPerThread * threads;
+            generateInputs( genOpts, v1, v2 );
+        }
+        int numStrips = stripsPerThread ? strips * threads : strips;
+        cerr << mode << " scaling: " << threads << " threads, " << numStrips << " strips, " 
+             << v1.size() + v2.size() << " halfsegments" << endl;
+        points.push_back( measure( backend, threads, numStrips, warmups, reps, v1, v2 ) );
+    }
+
+    // the efficiencies are relative to the first thread count, normally 1
+    const scalingPoint& base = points[0];
+    std::ofstream csv;
+    if( !csvFileName.empty() ) {
+        csv.open( csvFileName.c_str(), std::ofstream::out | std::ofstream::app );
+    }
+    cout << mode << " scaling on " << base.backend << ", median ms per phase, then parallel efficiency per phase" << endl;
+    cout << std::setw( 8 ) << "threads" << std::setw( 8 ) << "strips" << std::setw( 12 ) << "hsegs";
+    for( int f = 0; f < NUM_PHASES; f++ ) {
+        cout << std::setw( 11 ) << PHASE_NAMES[f];
+    }
+    for( int f = 0; f < NUM_PHASES; f++ ) {
+        cout << std::setw( 11 ) << PHASE_NAMES[f];
+    }
+    cout << endl;
+    for( int i = 0; i < points.size(); i++ ) {
+        const scalingPoint& p = points[i];
+        double efficiency[ NUM_PHASES ];
+        for( int f = 0; f < NUM_PHASES; f++ ) {
+            double scale = ( mode == "strong" ) ? (double) p.threads / base.threads : 1.0;
+            efficiency[f] = ( p.phase[f] > 0 ) ? base.phase[f] / ( scale * p.phase[f] ) : 0;
+        }
+        cout << std::setw( 8 ) << p.threads << std::setw( 8 ) << p.strips << std::setw( 12 ) << p.segs
+             << std::fixed << std::setprecision( 3 );
+        for( int f = 0; f < NUM_PHASES; f++ ) {
+            cout << std::setw( 11 ) << p.phase[f] * 1000;
+        }
+        cout << std::setprecision( 2 );
+        for( int f = 0; f < NUM_PHASES; f++ ) {
+            cout << std::setw( 11 ) << efficiency[f];
+        }
+        cout << endl;
+        if( csv.is_open() ) {
+            csv << mode << "," << p.backend << "," << p.threads << "," << p.strips << "," << p.segs;
+            for( int f = 0; f < NUM_PHASES; f++ ) {
+                csv << "," << p.phase[f];
+            }
+            for( int f = 0; f < NUM_PHASES; f++ ) {
+                csv << "," << efficiency[f];
+            }
+            csv << endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include "parPlaneSweep.h"
+#include "executor.h"
+#include "generatedRegions.h"
+using namespace std;
+
+/**
+ * Checks that parallelCreateFinalOverlay(), which parallelOverlay() stitches the strips with,
+ * produces the same halfsegments in the same order as the serial createFinalOverlay() of the 
+ * original code.  Every backend is run at 1 and 4 threads and 2 to 64 strips, on a generated 
+ * region pair and on one with colinear overlapping edges.
+ *
+ * Prints each mismatch and exits with 1 if there is any, 0 otherwise.
+ */
+int main( int argc, char * argv[] ) 
+{
+    const char * const backends[] = { "omp", "tbb", "c17", "pool" };
+    const int threadCounts[] = { 1, 4 };
+    genOptions inputs[2];
+    inputs[0].segments = inputs[1].segments = 10000;
+    inputs[1].colinear = 0.3;
+    int checked = 0, failed = 0;
+    for( int in = 0; in < 2; in++ ) {
+        vector< halfsegment > v1, v2;
+        generateInputs( inputs[in], v1, v2 );
+        for( int b = 0; b < 4; b++ ) {
+            for( int t = 0; t < 2; t++ ) {
+                OverlayContext context( threadCounts[t], backendFromName( backends[b] ) );
+                for( int strips = 2; strips <= 64; strips *= 2 ) {
+                    vector< halfsegment > parallel, serial;
+                    StripedOverlayResult striped;
+                    parallelOverlay( context, v1, v2, parallel, strips );
+                    parallelOverlay( context, v1, v2, striped, strips );
+                    createFinalOverlay( serial, striped.resultStrips, striped.isoBounds );
+                    checked++;
+                    if( parallel != serial ) {
+                        failed++;
+                        cout << "mismatch: input " << in << ", " << backends[b] << ", " << threadCounts[t] 
+                             << " threads, " << strips << " strips: parallel " << parallel.size() 
+                             << " halfsegments, serial " << serial.size() << endl;
+                    }
+                }
+            }
+        }
+    }
+    cout << "stitchTest: " << checked - failed << " of " << checked << " configurations match" << endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+#ifndef SWEEPCOUNTERS_H
+#define SWEEPCOUNTERS_H
+
+/**
+ * \file
+ *
+ * Event counters for the plane sweep.  Build with -DSWEEP_COUNTERS (make SWEEP_COUNTERS=1) to
+ * turn them on.  Otherwise the SWEEP_COUNT macros compile to nothing, and the counters
+ * handed back in OverlayStats stay zero with enabled set to false.
+ *
+ * Each thread counts into its own thread_local sweepCounters, so the hot path is a plain 
+ * increment.  A strip's counters are the difference of its thread's counters before and after
+ * the strip's sweep, since a sweep runs start to finish on one thread.
+ */
+
+/// active list length histogram buckets: 0, 1, 2-3, 4-7, ... , 2^(AL_LENGTH_BUCKETS-2) and up
+const int AL_LENGTH_BUCKETS = 16;
+
+/**
+ * \struct sweepCounters
+ *
+ * \brief counts of what the plane sweep did.
+ */
+struct sweepCounters {
+	/// false if the library was built without SWEEP_COUNTERS
+	bool enabled;
+	/// events taken from region 1, region 2, and the discovered event queue
+	long long r1Events, r2Events, discoveredEvents;
+	/// events on left and on right halfsegments
+	long long leftEvents, rightEvents;
+	/// calls to activeListVec::alHsegLT()
+	long long alCompares;
+	/// halfsegments inserted into the discovered event queue
+	long long eventQueueInserts;
+	/// calls to breakHsegs(), and the calls that broke the halfsegments up
+	long long breakCalls, breakHits;
+	/// intersections where the halfsegments overlap (colinear)
+	long long colinearOverlaps;
+	/// number of events seen with the active list length in each bucket, see AL_LENGTH_BUCKETS
+	long long alLengthHistogram[ AL_LENGTH_BUCKETS ];
+
+	sweepCounters( ) {
+		clear();
+	}
+
+	void clear( ) {
+		enabled = false;
+		r1Events = r2Events = discoveredEvents = leftEvents = rightEvents = 0;
+		alCompares = eventQueueInserts = breakCalls = breakHits = colinearOverlaps = 0;
+		for( int i = 0; i < AL_LENGTH_BUCKETS; i++ ) {
+			alLengthHistogram[i] = 0;
+		}
+	}
+
+	/// add (sign = 1) or subtract (sign = -1) another set of counters
+	void add( const sweepCounters &other, int sign = 1 ) {
+		enabled = enabled || other.enabled;
+		r1Events += sign * other.r1Events;
+		r2Events += sign * other.r2Events;
+		discoveredEvents += sign * other.discoveredEvents;
+		leftEvents += sign * other.leftEvents;
+		rightEvents += sign * other.rightEvents;
+		alCompares += sign * other.alCompares;
+		eventQueueInserts += sign * other.eventQueueInserts;
+		breakCalls += sign * other.breakCalls;
+		breakHits += sign * other.breakHits;
+		colinearOverlaps += sign * other.colinearOverlaps;
+		for( int i = 0; i < AL_LENGTH_BUCKETS; i++ ) {
+			alLengthHistogram[i] += sign * other.alLengthHistogram[i];
+		}
+	}
+};
+
+/// the histogram bucket of an active list length
+inline int alLengthBucket( int length )
+{
+	int bucket = 0;
+	while( length > 0 && bucket < AL_LENGTH_BUCKETS-1 ) {
+		length >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+#ifdef SWEEP_COUNTERS
+/// the calling thread's counters
+extern thread_local sweepCounters threadSweepCounters;
+#define SWEEP_COUNT( field ) ( threadSweepCounters.field++ )
+#define SWEEP_COUNT_AL_LENGTH( length ) ( threadSweepCounters.alLengthHistogram[ alLengthBucket( length ) ]++ )
+#else
+#define SWEEP_COUNT( field ) 
+#define SWEEP_COUNT_AL_LENGTH( length ) 
+#endif
+
+#endif
@@ -14,6 +14,7 @@
 
 
 #include "halfsegment.h"
+#include "sweepCounters.h"
 #include <cstdlib>
 #include <iomanip>
 // event queue contains a vector and is sorted in hseg order
@@ -53,6 +54,7 @@ class eventQueue
          *  The queue is more like a priority queue, it is always sorted.
          */
         void insert( const halfsegment & h1 ){
+            SWEEP_COUNT( eventQueueInserts );
             if( eq.empty() || eq[eq.size()-1] < h1 ) {
                 eq.push_back( h1 );
                 return;
@@ -151,6 +153,7 @@ class activeListVec
          */
         bool alHsegLT( const halfsegment &h1, const halfsegment &h2 )
         {
+            SWEEP_COUNT( alCompares );
             // if equal, indicate
             if( h1 == h2 )
                 return false;
@@ -454,6 +457,13 @@ class activeListVec
 	    }
 	}
 
+        /**
+         * Get the number of halfsegments in the active list
+         */
+        int size(){
+            return al.size();
+        }
+
         /**
          *  Print function for debugging
          */
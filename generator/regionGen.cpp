@@ -0,0 +1,100 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+// Writes a pair of regions in the .hex format read by frameworks/pps and preprocessing/pps.
+// See regionGen.h for how the regions are built.
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include "regionGen.h"
+
+using namespace std;
+
+/**
+ * Format a double as the 16 hex digits of its bits, as doubleHexConverter::hex2d() reads it
+ */
+void writeHex( FILE* out, double d )
+{
+    unsigned long long bits;
+    memcpy( &bits, &d, sizeof( bits ) );
+    fprintf( out, "%016llx ", bits );
+}
+
+/**
+ * Writes two region files for benchmarking the overlay.
+ *
+ * The command line arguments required are:
+ *  - [the approximate number of segments in each region]
+ *  - [the output hex file for region 1]
+ *  - [the output hex file for region 2]
+ *
+ * Optional arguments, in any order after those:
+ *  - -d [intersection density, 0-1]: fraction of cells where the two regions' polygons cross.
+ *    In the other cells the region 2 polygon is nested inside the region 1 polygon (default 0.5)
+ *  - -l [colinear overlap rate, 0-1]: fraction of cells where the region 2 polygon is the region
+ *    1 polygon moved along one of its edges, so that edge overlaps its copy (default 0)
+ *  - -c [clustering, 0-1]: 0 spreads the cells evenly over the map, higher values pack them
+ *    around the middle, which unbalances the strips (default 0)
+ *  - -v [vertical edge ratio, 0-1]: chance of each chain step and polygon end being a 
+ *    vertical edge (default 0.1)
+ *  - -s [seed]: random seed, the same arguments and seed give the same files (default 1)
+ */
+int main( int argc, char* argv[] )
+{
+    if( argc < 4 || ( argc - 4 ) % 2 != 0 ) {
+        cerr << "usage: regionGen [segments] [output file 1] [output file 2] [-d density] [-l colinear] [-c clustering] [-v vertical] [-s seed]" << endl;
+        exit( -1 );
+    }
+    genOptions opts;
+    opts.segments = atoll( argv[1] );
+    for( int i = 4; i < argc; i += 2 ) {
+        string flag( argv[i] );
+        double value = atof( argv[i+1] );
+        if( flag == "-d" ) opts.density = value;
+        else if( flag == "-l" ) opts.colinear = value;
+        else if( flag == "-c" ) opts.clustering = value;
+        else if( flag == "-v" ) opts.vertical = value;
+        else if( flag == "-s" ) opts.seed = atoi( argv[i+1] );
+        else {
+            cerr << "unknown option: " << flag << endl;
+            exit( -1 );
+        }
+    }
+    FILE* out[2];
+    for( int r = 0; r < 2; r++ ) {
+        out[r] = fopen( argv[2+r], "w" );
+        if( out[r] == NULL ) {
+            cerr << "Error: could not open file: " << argv[2+r] << endl;
+            exit( -1 );
+        }
+    }
+
+    long long written[2] = { 0, 0 };
+    generateRegions( opts, [&] ( int r, const vector<genSegment>& segs ) {
+        for( int i = 0; i < segs.size(); i++ ) {
+            writeHex( out[r], segs[i].dx );
+            writeHex( out[r], segs[i].dy );
+            writeHex( out[r], segs[i].sx );
+            writeHex( out[r], segs[i].sy );
+            fprintf( out[r], "%d %d\n", segs[i].la, segs[i].lb );
+        }
+        written[r] += segs.size();
+    });
+    for( int r = 0; r < 2; r++ ) {
+        fclose( out[r] );
+        cerr << argv[2+r] << ": " << written[r] << " segments" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,312 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) <2016> <Mark McKenney>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ * */
+
+
+// Generates pairs of labeled regions for benchmarking the overlay.  regionGen writes them to
+// .hex files, the frameworks scaling harness generates them in memory.
+//
+// The map is a grid of cells, and each cell holds one polygon of region 1 and one of region 2.
+// Polygons stay inside their cell, so polygons of the same region never touch and each
+// region is valid.  How the two polygons of a cell meet is what the knobs control.
+//
+// A polygon is x-monotone: a lower chain below the middle of its cell and an upper chain 
+// above it, both running left to right.  Chains never enter the band around the middle of the
+// cell, which is where a nested polygon of the other region goes.
+//
+// Coordinates are multiples of 2^-20, so the colinear overlaps are exactly colinear.
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+
+#ifndef REGIONGEN_H
+#define REGIONGEN_H
+
+using namespace std;
+
+/// the expected number of edges of a polygon, used to size the grid
+const int EXPECTED_POLYGON_EDGES = 10;
+/// chain vertices stay at least this far (as a fraction of the cell height) from the middle of the cell
+const double BAND = 0.05;
+
+/**
+ * The knobs of the generator
+ */
+struct genOptions {
+    long long segments;     ///< approximate number of segments per region
+    double density;         ///< fraction of cells where the polygons cross
+    double colinear;        ///< fraction of cells where the polygons have colinear overlapping edges
+    double clustering;      ///< 0 spreads the cells evenly, up to 1 packs them around the middle of the map
+    double vertical;        ///< chance of each chain step and polygon end being a vertical edge
+    unsigned int seed;      ///< random seed
+
+    genOptions( ) : segments( 1000 ), density( 0.5 ), colinear( 0 ), clustering( 0 ), vertical( 0.1 ), seed( 1 ) { }
+};
+
+struct point {
+    double x, y;
+};
+
+/**
+ * A generated segment: the dominating point, the submissive point, and the labels above and below
+ */
+struct genSegment {
+    double dx, dy, sx, sy;
+    int la, lb;
+};
+
+/**
+ * Round to a multiple of 2^-20
+ */
+inline double quantize( double v )
+{
+    return ldexp( nearbyint( ldexp( v, 20 ) ), -20 );
+}
+
+/**
+ * The bounds of the grid columns (or rows).  With clustering, cells near the middle of the
+ * map are narrower, so more segments fall there.
+ *
+ * @param [in] side: the number of columns
+ * @param [in] clustering: 0 for even columns, up to 1 for strongly clustered
+ * @param [out] bounds: side+1 increasing bounds from 0 to side
+ */
+inline void gridBounds( int side, double clustering, vector<double>& bounds )
+{
+    vector<double> widths( side );
+    double total = 0;
+    for( int i = 0; i < side; i++ ) {
+        double u = ( i + 0.5 ) / side - 0.5;
+        widths[i] = 1.0 / ( 1.0 + clustering * 50 * exp( -u*u / 0.02 ) );
+        total += widths[i];
+    }
+    bounds.assign( 1, 0.0 );
+    double sum = 0;
+    for( int i = 0; i < side; i++ ) {
+        sum += widths[i] * side / total;
+        bounds.push_back( quantize( sum ) );
+    }
+}
+
+/**
+ * Build one chain of a polygon from left to right
+ *
+ * @param [in] xs: the x values of the chain's vertices, increasing
+ * @param [in] lo, hi: the y range of the chain's vertices
+ * @param [in] vertical: chance of each step getting a vertical edge
+ * @param [out] chain: the chain's vertices
+ */
+inline void makeChain( const vector<double>& xs, double lo, double hi, double vertical, 
+                mt19937_64& gen, vector<point>& chain )
+{
+    uniform_real_distribution<double> U( 0, 1 );
+    chain.clear();
+    for( int i = 0; i < xs.size(); i++ ) {
+        if( i > 0 && U( gen ) < vertical ) {
+            // reach this x at another height, then step vertically
+            point p = { xs[i], quantize( lo + ( hi - lo ) * U( gen ) ) };
+            chain.push_back( p );
+        }
+        point p = { xs[i], quantize( lo + ( hi - lo ) * U( gen ) ) };
+        if( !chain.empty() && chain.back().x == p.x && chain.back().y == p.y ) {
+            continue;
+        }
+        chain.push_back( p );
+    }
+}
+
+/**
+ * The end of a polygon: a point on the middle line, or a vertical edge from the lower band to
+ * the upper band.  The heights are random, so the edges to the chains are not horizontal
+ *
+ * @param [out] end: the end's points, bottom first
+ */
+inline void makeEnd( double x, double mid, double h, bool vertical, mt19937_64& gen, vector<point>& end )
+{
+    uniform_real_distribution<double> U( 0, 1 );
+    end.clear();
+    if( !vertical ) {
+        point p = { x, mid };
+        end.push_back( p );
+        return;
+    }
+    point p = { x, quantize( mid - h * ( BAND + ( 0.45 - BAND ) * U( gen ) ) ) };
+    point q = { x, quantize( mid + h * ( BAND + ( 0.45 - BAND ) * U( gen ) ) ) };
+    end.push_back( p );
+    end.push_back( q );
+}
+
+/**
+ * Generate a polygon in the box [x0,x1] x [y0,y1], around the middle line y = (y0+y1)/2.
+ * Chain vertices keep at least BAND of the box height away from the middle line.
+ *
+ * @param [out] polygon: the vertices in counter clockwise order
+ * @param [out] innerX0, innerX1: an x range where the polygon covers the band around the middle line
+ */
+inline void makePolygon( double x0, double x1, double y0, double y1, double vertical, mt19937_64& gen,
+                  vector<point>& polygon, double& innerX0, double& innerX1 )
+{
+    uniform_real_distribution<double> U( 0, 1 );
+    uniform_int_distribution<int> numVerts( 2, 6 );
+    double mid = quantize( ( y0 + y1 ) / 2 );
+    double h = y1 - y0;
+    double left = quantize( x0 + ( x1 - x0 ) * 0.25 * U( gen ) );
+    double right = quantize( x1 - ( x1 - x0 ) * 0.25 * U( gen ) );
+    // the x values of each chain, strictly between left and right
+    vector<double> xs[2];
+    for( int c = 0; c < 2; c++ ) {
+        int n = numVerts( gen );
+        for( int i = 1; i <= n; i++ ) {
+            double x = quantize( left + ( right - left ) * ( i - 0.5 + 0.8 * ( U( gen ) - 0.5 ) ) / n );
+            if( x > left && x < right && ( xs[c].empty() || x > xs[c].back() ) ) {
+                xs[c].push_back( x );
+            }
+        }
+        if( xs[c].empty() ) {
+            xs[c].push_back( quantize( ( left + right ) / 2 ) );
+        }
+    }
+    vector<point> lower, upper;
+    makeChain( xs[0], mid - 0.45*h, mid - BAND*h, vertical, gen, lower );
+    makeChain( xs[1], mid + BAND*h, mid + 0.45*h, vertical, gen, upper );
+    innerX0 = max( lower.front().x, upper.front().x );
+    innerX1 = min( lower.back().x, upper.back().x );
+
+    // ends are a point on the middle line, or a vertical edge
+    polygon.clear();
+    bool verticalLeft = U( gen ) < vertical;
+    bool verticalRight = U( gen ) < vertical;
+    vector<point> leftEnd, rightEnd;
+    makeEnd( left, mid, h, verticalLeft, gen, leftEnd );
+    makeEnd( right, mid, h, verticalRight, gen, rightEnd );
+    polygon.push_back( leftEnd[0] );
+    polygon.insert( polygon.end(), lower.begin(), lower.end() );
+    polygon.insert( polygon.end(), rightEnd.begin(), rightEnd.end() );
+    polygon.insert( polygon.end(), upper.rbegin(), upper.rend() );
+    if( verticalLeft ) {
+        polygon.push_back( leftEnd[1] );
+    }
+}
+
+/**
+ * The edges of a counter clockwise polygon as labeled segments.  The interior is labeled 1 and
+ * the exterior 0.  Left of the direction of travel is the interior, and the label above a 
+ * segment is the one to the left of its dominating to submissive direction.
+ *
+ * @param [in] polygon: the vertices in counter clockwise order
+ * @param [out] segs: the segments
+ */
+inline void polygonSegments( const vector<point>& polygon, vector<genSegment>& segs )
+{
+    segs.clear();
+    for( int i = 0; i < polygon.size(); i++ ) {
+        point a = polygon[i];
+        point b = polygon[ ( i + 1 ) % polygon.size() ];
+        if( a.x == b.x && a.y == b.y ) {
+            continue;
+        }
+        int la = 1, lb = 0;
+        if( !( a.x < b.x || ( a.x == b.x && a.y < b.y ) ) ) {
+            swap( a, b );
+            la = 0;
+            lb = 1;
+        }
+        genSegment s = { a.x, a.y, b.x, b.y, la, lb };
+        segs.push_back( s );
+    }
+}
+
+/**
+ * Generate a pair of regions, one cell at a time, until region 1 has at least opts.segments
+ * segments or the grid is full.
+ *
+ * @param [in] opts: the knobs
+ * @param [in] emit: called with the region (0 or 1) and the segments of each polygon
+ */
+inline void generateRegions( const genOptions& opts, 
+                             const function< void( int, const vector<genSegment>& ) >& emit )
+{
+    long long cells = max( 1LL, opts.segments / EXPECTED_POLYGON_EDGES );
+    int side = (int) ceil( sqrt( (double) cells ) );
+    vector<double> xBounds, yBounds;
+    gridBounds( side, opts.clustering, xBounds );
+    gridBounds( side, opts.clustering, yBounds );
+
+    mt19937_64 gen( opts.seed );
+    uniform_real_distribution<double> U( 0, 1 );
+    vector<point> polygon[2];
+    vector<genSegment> segs;
+    long long written = 0;
+    // fill cells until region 1 has enough segments
+    for( long long c = 0; c < (long long) side * side && written < opts.segments; c++ ) {
+        double x0 = xBounds[ c % side ], x1 = xBounds[ c % side + 1 ];
+        double y0 = yBounds[ c / side ], y1 = yBounds[ c / side + 1 ];
+        // keep a margin to the neighboring cells
+        double mx = ( x1 - x0 ) * 0.05, my = ( y1 - y0 ) * 0.05;
+        double innerX0, innerX1, unusedX0, unusedX1;
+        makePolygon( x0 + mx, x1 - mx, y0 + my, y1 - my, opts.vertical, gen, polygon[0], innerX0, innerX1 );
+        double mode = U( gen );
+        // a diagonal edge to move the polygon along, moving along a vertical edge would not 
+        // move the polygon off its cell's middle line
+        int diagonal = 0;
+        while( diagonal < polygon[0].size() ) {
+            const point &a = polygon[0][ diagonal ], &b = polygon[0][ ( diagonal + 1 ) % polygon[0].size() ];
+            if( a.x != b.x && a.y != b.y ) {
+                break;
+            }
+            diagonal++;
+        }
+        if( mode < opts.colinear && diagonal < polygon[0].size() ) {
+            // move along the edge by a power of two fraction of it, so the moved vertices stay
+            // exact and the edge stays on its line.  Shrink the move to stay in the cell
+            const point &a = polygon[0][ diagonal ], &b = polygon[0][ ( diagonal + 1 ) % polygon[0].size() ];
+            double ex = b.x - a.x;
+            double ey = b.y - a.y;
+            double t = 0.5;
+            while( fabs( t*ex ) >= mx || fabs( t*ey ) >= my ) {
+                t /= 2;
+            }
+            polygon[1] = polygon[0];
+            for( int i = 0; i < polygon[1].size(); i++ ) {
+                polygon[1][i].x += t*ex;
+                polygon[1][i].y += t*ey;
+            }
+        }
+        else if( mode < opts.colinear + opts.density ) {
+            makePolygon( x0 + mx, x1 - mx, y0 + my, y1 - my, opts.vertical, gen, polygon[1], unusedX0, unusedX1 );
+        }
+        else {
+            // nested in the band the region 1 polygon always covers
+            double h = y1 - y0 - 2*my;
+            double b = BAND * h * 0.8;
+            double w = innerX1 - innerX0;
+            if( w <= 0 ) {
+                // the chains do not overlap in x, leave region 2 out of this cell
+                polygon[1].clear();
+            }
+            else {
+                makePolygon( innerX0 + w*0.05, innerX1 - w*0.05, quantize( ( y0 + y1 ) / 2 ) - b, 
+                             quantize( ( y0 + y1 ) / 2 ) + b, opts.vertical, gen, polygon[1], unusedX0, unusedX1 );
+            }
+        }
+        for( int r = 0; r < 2; r++ ) {
+            polygonSegments( polygon[r], segs );
+            if( r == 0 ) {
+                written += segs.size();
+            }
+            emit( r, segs );
+        }
+    }
+}
+
+#endif
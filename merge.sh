@@ -0,0 +1,26 @@
+#!/bin/bash
+# Compare the per-thread vector recombination strategies at fixed preprocessing
+# thread counts. Results for each thread count go to merge-threads-N/preprocessing.csv
+PROJ_DIR=$(pwd)/preprocessing
+IMPLEMENTATION="serialrecombine tmerge losertree mergepath"
+THREADS="8 16 32 64 128"
+MIN=2
+MAX=2048
+export LD_LIBRARY_PATH=$PROJ_DIR
+# generate the regions if they are missing
+if [ ! -f data/1k1.hex ]; then
+	make -C generator && mkdir -p data && generator/regionGen 1000 data/1k1.hex data/1k2.hex
+fi
+for T in $THREADS
+do
+	export PPS_PREPROCESS_THREADS=$T
+	mkdir -p merge-threads-$T
+	for i in {1..100}
+	do
+		for IMPL in $IMPLEMENTATION
+		do
+			echo "Threads $T iteration $i $IMPL"
+			(cd merge-threads-$T && "$PROJ_DIR"/"$IMPL" "$PROJ_DIR"/../data/1k1.hex "$PROJ_DIR"/../data/1k2.hex "$MIN" "$MAX");
+		done;
+	done;
+done;
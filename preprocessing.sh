@@ -1,9 +1,13 @@
 #!/bin/bash
 PROJ_DIR=./preprocessing/
-IMPLEMENTATION="pps serialrecombine mutexlock conditionalmutex altconditionalmutex tmerge"
+IMPLEMENTATION="pps serialrecombine mutexlock conditionalmutex altconditionalmutex tmerge lockfree losertree mergepath fused"
 MIN=2
 MAX=2048
 export LD_LIBRARY_PATH=$PROJ_DIR
+# generate the regions if they are missing
+if [ ! -f data/1k1.hex ]; then
+	make -C generator && mkdir -p data && generator/regionGen 1000 data/1k1.hex data/1k2.hex
+fi
 for i in {1..100}
 do	
 	for IMPL in $IMPLEMENTATION
@@ -31,6 +31,19 @@ void tokenizeString(const std::string& str,
         std::vector<string>& tokens, 
         const string& delimiters );
 
+/**
+ * Append the strip creation times of one overlay to preprocessing.csv, one 
+ * implementation,numStrips,time line per createStrips call
+ * @param [in] stats: the timings filled in by parallelOverlay
+ */
+void writeStatsCsv( const OverlayStats& stats );
+
+/**
+ * Append the timings and sizes of one overlay to preprocessing.json, one json object per line
+ * @param [in] stats: the timings filled in by parallelOverlay
+ */
+void writeStatsJson( const OverlayStats& stats );
+
 
 /**
  * The main function provides examples of how to call the serial and 
@@ -46,6 +59,7 @@ void tokenizeString(const std::string& str,
  *  - [an input hex file with region 2]
  *  - [the number of strips to begin running the program with]
  *  - [the number of strips to stop at]
+ *  - optional: [csv, json or none] where to write the timings of each run (default csv)
  *
  *  The program repeatedly runs a plan sweep algorithm on the input
  *  with increasing numbers of strips. Strip counts increase quadratically. 
@@ -57,11 +71,21 @@ int main( int argc, char * argv[] )
     std::string inputFileName1, inputFileName2;
     vector< halfsegment >v1, v2, result;
     int minStrips, maxStrips;
-    if( argc != 5 )
+    string statsFormat = "csv";
+    if( argc != 5 && argc != 6 )
     {
-        std::cerr << "usage: exe  [input file name 1] [input file name 2] [min strips][max strips]" << std::endl;
+        std::cerr << "usage: exe  [input file name 1] [input file name 2] [min strips][max strips] [csv|json|none]" << std::endl;
         exit( -1 );
     }
+    if( argc == 6 )
+    {
+        statsFormat = argv[5];
+        if( statsFormat != "csv" && statsFormat != "json" && statsFormat != "none" )
+        {
+            std::cerr << "unknown stats format: " << statsFormat << ", use csv, json or none" << std::endl;
+            exit( -1 );
+        }
+    }
     {
         std::stringstream ss1;
         ss1 << argv[1];
@@ -179,7 +203,14 @@ int main( int argc, char * argv[] )
             overlayPlaneSweep( &(v1[0]), v1.size(), &(v2[0]), v2.size(), result );
         }
         else {
-            parallelOverlay( v1, v2, result, i);
+            OverlayStats stats;
+            parallelOverlay( v1, v2, result, i, -1, &stats );
+            if( statsFormat == "csv" ) {
+                writeStatsCsv( stats );
+            }
+            else if( statsFormat == "json" ) {
+                writeStatsJson( stats );
+            }
         }
         cout << "num segs: " << result.size()/2<<endl;
 
@@ -201,3 +232,33 @@ void tokenizeString(const std::string& str, std::vector<string>& tokens, const s
     }
 }
 
+void writeStatsCsv( const OverlayStats& stats )
+{
+    std::ofstream csv;
+    csv.open( "preprocessing.csv", std::ofstream::out | std::ofstream::app );
+    csv << stats.implementation << "," << stats.numStrips << "," << stats.r1StripsTime << std::endl;
+    // implementations that split both regions in one pass have a single time
+    if( stats.r2StripsTime >= 0 ) {
+        csv << stats.implementation << "," << stats.numStrips << "," << stats.r2StripsTime << std::endl;
+    }
+    csv.close();
+}
+
+void writeStatsJson( const OverlayStats& stats )
+{
+    std::ofstream json;
+    json.open( "preprocessing.json", std::ofstream::out | std::ofstream::app );
+    json << "{\"implementation\": \"" << stats.implementation << "\""
+         << ", \"findBoundsTime\": " << stats.findBoundsTime
+         << ", \"r1StripsTime\": " << stats.r1StripsTime
+         << ", \"r2StripsTime\": " << stats.r2StripsTime
+         << ", \"sweepTime\": " << stats.sweepTime
+         << ", \"recombineTime\": " << stats.recombineTime
+         << ", \"numStrips\": " << stats.numStrips
+         << ", \"r1Segs\": " << stats.r1Segs
+         << ", \"r2Segs\": " << stats.r2Segs
+         << ", \"r1StripSegs\": " << stats.r1StripSegs
+         << ", \"r2StripSegs\": " << stats.r2StripSegs
+         << ", \"resultSegs\": " << stats.resultSegs << "}" << std::endl;
+    json.close();
+}
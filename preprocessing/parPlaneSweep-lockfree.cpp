@@ -9,6 +9,9 @@
  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  * */
 
+/* Code edited by Eric Lehmann will be marked ELEHMANN for ease of identification. */
+// This implementation builds the strips without locks. Every thread reserves its own
+// bucket in each strip up front, so only the individual strips are sorted afterwards.
 
 #include <iomanip>
 #include "parPlaneSweep.h"
@@ -17,6 +20,7 @@
 #include <numeric>
 #include <execution>
 #include <algorithm>
+#include <thread>
 
 /**
  * A binary search function
@@ -88,12 +92,13 @@ void findIsoBoundaries( vector<halfsegment> &r1, vector<halfsegment> &r2,
 /**
  *  Break an input region up into strips.  Strip boundaries are isoBounds
  *
+ *  \param rThreads the thread budget for this region (see splitThreadBudget())
  *  \param region the region to split into strips
  *  \param isoBounds  the strip boundaries
  *  \param rStrips [out] the region broken into strips.  Each halfsegment will have a strip ID indicating the strip to which it belongs.  stripIDs start at 0 and increment.
  *  \param stripStopIndex [out] halfsegments in rStrips are sorted by strip ID then halfsegment ordering.  This vector marks the positions in the rStrips array where the last halfsegment in each strip is located.
  */
-void createStrips( vector< halfsegment> & region, vector<double> &isoBounds, 
+void createStrips(unsigned int rThreads, vector< halfsegment> & region, vector<double> &isoBounds, 
 									 vector<halfsegment> & rStrips, 	vector< int > &stripStopIndex );
 
 
@@ -156,7 +161,7 @@ void insertBrokenSegsToActiveListAndDiscoveredQueue( const vector<halfsegment> &
  * See the prototype in parPlaneSweep.h
  */
 void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, vector<halfsegment> &result, 
-							int numStrips, int numWorkerThreads )
+							int numStrips, int numWorkerThreads, OverlayStats *stats )
 {
 	vector<halfsegment> r1Strips, r2Strips;
 	vector< double > isoBounds;
@@ -165,7 +170,9 @@ void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, vector<h
 	result.clear();  // make sure the result vec is clear
 
 		// set default parallel values
-	if ( numWorkerThreads > 0 ) {
+if ( numWorkerThreads > 0 ) {
+	}
+	else {
 	}
 	if (numStrips < 0) {
 		numStrips = 1;
@@ -183,34 +190,59 @@ void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, vector<h
 	} 
 	
 	// find split points
+	std::chrono::time_point<std::chrono::system_clock> bounds_start = std::chrono::system_clock::now();
 	findIsoBoundaries( r1, r2, isoBounds );
+	std::chrono::duration<double> bounds_duration = std::chrono::system_clock::now() - bounds_start;
 
 	// split up the regions at the iso boundaries
-// ELEHMANN
+	//
+// ELEHMANN 
+	std::chrono::duration<double> strips_duration[2];
 	int track_regions[] = {0,1};
-
+	unsigned int r1Threads, r2Threads;
+	splitThreadBudget( numWorkerThreads, r1.size(), r2.size(), r1Threads, r2Threads );
 	std::for_each( std::execution::par, std::begin(track_regions), std::end(track_regions), [&] (int i){
-		if( i == 0 ) createStrips( r1, isoBounds, r1Strips, r1StripStopIndex );
-		else  createStrips( r2, isoBounds, r2Strips, r2StripStopIndex );
+		std::chrono::time_point<std::chrono::system_clock> strips_start = std::chrono::system_clock::now();
+		if( i == 0 ) createStrips( r1Threads, r1, isoBounds, r1Strips, r1StripStopIndex );
+		else  createStrips( r2Threads, r2, isoBounds, r2Strips, r2StripStopIndex );
+		strips_duration[i] = std::chrono::system_clock::now() - strips_start;
 		});
+	std::chrono::time_point<std::chrono::system_clock> sweep_start = std::chrono::system_clock::now();
 	std::vector<int> track_strips(numStrips);
 	std::iota( track_strips.begin(), track_strips.end(), 0);
-	std::chrono::time_point<std::chrono::system_clock> sweep_start = std::chrono::system_clock::now();
 	std::for_each( std::execution::par, track_strips.begin(), track_strips.end(), [&] (int i) {
 		partialOverlay( r1Strips, r2Strips, resultStrips[i], r1StripStopIndex, r2StripStopIndex, i );
-	});
-	std::chrono::time_point<std::chrono::system_clock> sweep_end = std::chrono::system_clock::now();
-	std::chrono::time_point<std::chrono::system_clock> reconstruct_start = std::chrono::system_clock::now();
-	createFinalOverlay(  result, resultStrips, isoBounds );
-	std::chrono::time_point<std::chrono::system_clock> reconstruct_end = std::chrono::system_clock::now();
-	std::chrono::duration<double> sweep_duration = sweep_end - sweep_start;
-	std::chrono::duration<double> reconstruct_duration = reconstruct_end - reconstruct_start;
-	std::ofstream csv;
-	csv.open("frameworks.csv", std::ofstream::out | std::ofstream::app);
-	csv << "c17," << sweep_duration.count() << "," << reconstruct_duration.count() << "," << numStrips << std::endl;
-	csv.close();
+		});
+	std::chrono::duration<double> sweep_duration = std::chrono::system_clock::now() - sweep_start;
 // END
+
+//tbb::parallel_for(0, numStrips, [&](int i) {
+//	partialOverlay( r1Strips, r2Strips, resultStrips[i], r1StripStopIndex, r2StripStopIndex, i );
+//	});
+	// create the final overlay
+	std::chrono::time_point<std::chrono::system_clock> recombine_start = std::chrono::system_clock::now();
+	createFinalOverlay(  result,
+										 resultStrips, 
+												isoBounds );
+	std::chrono::duration<double> recombine_duration = std::chrono::system_clock::now() - recombine_start;
+
+	if( stats != NULL ) {
+		stats->implementation = "Lock Free";
+		stats->findBoundsTime = bounds_duration.count();
+		stats->r1StripsTime = strips_duration[0].count();
+		stats->r2StripsTime = strips_duration[1].count();
+		stats->r1StripSegs = r1Strips.size();
+		stats->r2StripSegs = r2Strips.size();
+		stats->sweepTime = sweep_duration.count();
+		stats->recombineTime = recombine_duration.count();
+		stats->numStrips = numStrips;
+		stats->r1Segs = r1.size();
+		stats->r2Segs = r2.size();
+		stats->resultSegs = result.size();
+	}
+
 }
+
 // call the individual overlay functions.
 // this function just sets up the function calls to overlayPlaneSweep
 /**
@@ -669,77 +701,145 @@ bool hsegIDSort( const halfsegment & h1, const halfsegment & h2 )
 		return h1.stripID < h2.stripID || (h1.stripID == h2.stripID && h1 < h2 );
 }
 
-void createStrips( vector< halfsegment> & region, vector<double> &isoBounds, 
-									 vector<halfsegment> & rStrips, 	vector< int > &stripStopIndex )
+/**
+ *  Compute the range of region indexes a strip building thread is responsible for.
+ *  Every thread gets an equal share, the last thread also picks up the remainder.
+ */
+void threadRange( unsigned int threadnum, unsigned int threadcount, int regionSize, int &threadMin, int &threadMax )
+{
+	threadMin = threadnum * (regionSize/threadcount);
+	if( threadnum == threadcount-1 ) {
+		threadMax = regionSize;
+	}
+	else {
+		threadMax = threadMin + (regionSize/threadcount);
+	}
+}
+
+/**
+ *  First pass of the lock free strip construction.  Count how many halfsegments this thread
+ *  will place in each strip.  No halfsegments are built here, we only walk the iso bounds the 
+ *  same way the second pass does.
+ *
+ *  \param stripCounts [out] numStrips entries, one count per strip for this thread
+ */
+void countStrips( unsigned int threadnum, unsigned int threadcount, vector<halfsegment> &region, 
+									vector<double> &isoBounds, int *stripCounts )
+{
+	int threadMin, threadMax;
+	int startBound = 0;
+	threadRange( threadnum, threadcount, region.size(), threadMin, threadMax );
+	for( int i = threadMin; i < threadMax; i++ ) {
+		if( region[i].isLeft() ) {
+			for( int j = startBound; j < isoBounds.size()-1; j++ ) {
+				if( region[i].dx > isoBounds[j+1] ) {
+					startBound++;
+					continue;
+				}
+				// every piece contributes a left and a right halfsegment
+				stripCounts[j] += 2;
+				if( region[i].sx < isoBounds[j+1] ) {
+					break;
+				}
+			}
+		}
+	}
+}
+
+/**
+ *  Second pass of the lock free strip construction.  Clip this thread's halfsegments at the iso
+ *  bounds and write the pieces straight into the slots reserved for this thread in each strip.
+ *  The reserved ranges never overlap, so no locking is needed.
+ *
+ *  \param writePos [in/out] numStrips entries.  The next free slot in rStrips for each strip.
+ */
+void fillStrips( unsigned int threadnum, unsigned int threadcount, vector<halfsegment> &region, 
+								 vector<double> &isoBounds, vector<halfsegment> &rStrips, int *writePos )
 {
 	halfsegment workSeg;
+	int threadMin, threadMax;
 	int startBound = 0;
-	// grab a seg, break it on each strip that it crosses, put it in the strips
-	for( int i = 0; i< region.size(); i++ ) {
-		// only need to worry about lefties
-		if( region[i].isLeft( ) ) {
+	threadRange( threadnum, threadcount, region.size(), threadMin, threadMax );
+	for( int i = threadMin; i < threadMax; i++ ) {
+		if( region[i].isLeft() ) {
 			workSeg = region[i];
-			for( int j = startBound; j < isoBounds.size()-1; j++ ){
+			for( int j = startBound; j < isoBounds.size()-1; j++ ) {
 				if( workSeg.dx > isoBounds[j+1] ) {
-					// we are done with this strip (hseg ordering)
 					startBound++;
 					continue;
 				}
-				// check if we cross the boundary. 
-				// remember, we won't have any seg end on a boundary unless we split it
 				else if( workSeg.dx >= isoBounds[j] && workSeg.sx < isoBounds[j+1] ) {
 					workSeg.stripID = j;
-					rStrips.push_back( workSeg );
-					rStrips.push_back( workSeg.getBrother( ) );
-					break; // done with this seg
+					rStrips[ writePos[j]++ ] = workSeg;
+					rStrips[ writePos[j]++ ] = workSeg.getBrother();
+					break;
 				}
-				// otherwise, we cross a boundary
 				else {
-					// get the y value at iso bound
 					halfsegment lhs = workSeg;
-					// make the segs split at isoBounds[j]
 					lhs.sy = workSeg.dy = workSeg.getYvalAtX( isoBounds[j+1] );
 					lhs.sx = workSeg.dx = isoBounds[j+1];
 					lhs.stripID = j;
-					rStrips.push_back( lhs );
-					rStrips.push_back( lhs.getBrother() );
+					rStrips[ writePos[j]++ ] = lhs;
+					rStrips[ writePos[j]++ ] = lhs.getBrother();
 				}
 			}
 		}
 	}
-        // deallocate input segments (to save memory!)
-        // use the swap to local var trick!
-        //{
-          //  vector< halfsegment > localOne;
-           // region.swap(localOne);
-        //}
-
-	// sort the strips by stripID, then by hseg order
-
-	std::sort( rStrips.begin(), rStrips.end(), hsegIDSort);
-	// find the startIndex for each strip
-	for( int i = 0; i < isoBounds.size()-1; i++ )
-		stripStopIndex.push_back( std::numeric_limits<int>::min() ); 
-	for( int i = 0; i < rStrips.size(); i++ ){
-		if( i >= stripStopIndex[ rStrips[i].stripID ] )
-			stripStopIndex[ rStrips[i].stripID ] = i+1;
-	}
-	// remove any remaining min vals
-	int prevVal = 0;
-	for( int i = 0; i <  stripStopIndex.size(); i++ ) {
-		if( stripStopIndex[i] == std::numeric_limits<int>::min()  ) {
-			stripStopIndex[i] = prevVal;
+}
+
+/**
+ *  Lock free strip construction.
+ *
+ *  Each thread counts the halfsegments it produces for every strip, then a prefix sum over
+ *  the (strip, thread) counts reserves a contiguous bucket for each thread inside each strip
+ *  of a pre-sized rStrips.  Threads then fill their own buckets without any synchronization.
+ *  Since buckets are laid out strip by strip, rStrips is already grouped by strip ID and only
+ *  the individual strips need to be sorted (in parallel), not the whole vector.
+ */
+void createStrips( unsigned int rThreads,  vector< halfsegment> & region, vector<double> &isoBounds, 
+									 vector<halfsegment> & rStrips, 	vector< int > &stripStopIndex )
+{
+	unsigned int nthread = preprocessingThreadCount( rThreads, region.size() );
+	int numStrips = isoBounds.size()-1;
+	// bucket (strip, thread) lives at bucket[ strip*nthread + thread ]
+	vector<int> bucketStart( numStrips*nthread, 0 );
+	vector< vector<int> > threadCounts( nthread, vector<int>( numStrips, 0 ) );
+	std::vector<int> track_threads;
+	for (unsigned int i = 0; i < nthread; i++){track_threads.push_back(i);}
+	std::for_each( std::execution::par, track_threads.begin(), track_threads.end(), [&] (int i) {
+		countStrips( i, nthread, region, isoBounds, &(threadCounts[i][0]) );
+	});
+
+	// reserve the output slots
+	int total = 0;
+	for( int j = 0; j < numStrips; j++ ) {
+		for( unsigned int t = 0; t < nthread; t++ ) {
+			bucketStart[ j*nthread + t ] = total;
+			total += threadCounts[t][j];
 		}
-		prevVal = stripStopIndex[i];
+		stripStopIndex.push_back( total );
 	}
-	
+	rStrips.resize( total );
+
+	std::for_each( std::execution::par, track_threads.begin(), track_threads.end(), [&] (int i) {
+		vector<int> writePos( numStrips );
+		for( int j = 0; j < numStrips; j++ ) {
+			writePos[j] = bucketStart[ j*nthread + i ];
+		}
+		fillStrips( i, nthread, region, isoBounds, rStrips, &(writePos[0]) );
+	});
+
+	// every strip holds only its own halfsegments, so sort each strip independently
+	std::vector<int> track_strips( numStrips );
+	std::iota( track_strips.begin(), track_strips.end(), 0 );
+	std::for_each( std::execution::par, track_strips.begin(), track_strips.end(), [&] (int j) {
+		int stripStart = ( j == 0 ) ? 0 : stripStopIndex[j-1];
+		std::sort( rStrips.begin()+stripStart, rStrips.begin()+stripStopIndex[j] );
+	});
+
 #ifdef DEBUG_PRINT
 #pragma omp critical
 	{
-		/*		cerr << "strips: "<<endl;
-		for( int i = 0; i < rStrips.size(); i++ ) {
-			cerr <<"[(" << rStrips[i].dx << "," << rStrips[i].dy << ")(" << rStrips[i].sx << "," << rStrips[i].sy << ") " << rStrips[i].stripID << ", " << rStrips[i].la << ", " <<  rStrips[i].lb << "]" << endl;
-			}*/
 		cerr<< "stopIndex: " ;
 		for( int i = 0; i < stripStopIndex.size(); i++ )
 			cerr << stripStopIndex[i] << " ";
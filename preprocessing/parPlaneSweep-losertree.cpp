@@ -8,16 +8,17 @@
  *
  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  * */
-
-/* Code modified or added by Eric Lehmann will be marked ELEHMANN */
-
-
+/* Code edited by Eric Lehmann will be marked ELEHMANN for ease of identification. */
+// This implementation is tmerge, but merges the sorted per-thread vectors with a loser 
+// tree instead of scanning every vector for the minimum.
 #include <iomanip>
-#include <tbb/tbb.h>
 #include "parPlaneSweep.h"
 #include "vectorAlEq.h"
 #include <limits>
+#include <numeric>
+#include <execution>
 #include <algorithm>
+#include <thread>
 
 /**
  * A binary search function
@@ -89,12 +90,13 @@ void findIsoBoundaries( vector<halfsegment> &r1, vector<halfsegment> &r2,
 /**
  *  Break an input region up into strips.  Strip boundaries are isoBounds
  *
+ *  \param rThreads the thread budget for this region (see splitThreadBudget())
  *  \param region the region to split into strips
  *  \param isoBounds  the strip boundaries
  *  \param rStrips [out] the region broken into strips.  Each halfsegment will have a strip ID indicating the strip to which it belongs.  stripIDs start at 0 and increment.
  *  \param stripStopIndex [out] halfsegments in rStrips are sorted by strip ID then halfsegment ordering.  This vector marks the positions in the rStrips array where the last halfsegment in each strip is located.
  */
-void createStrips( vector< halfsegment> & region, vector<double> &isoBounds, 
+void createStrips(unsigned int rThreads, vector< halfsegment> & region, vector<double> &isoBounds, 
 									 vector<halfsegment> & rStrips, 	vector< int > &stripStopIndex );
 
 
@@ -157,7 +159,7 @@ void insertBrokenSegsToActiveListAndDiscoveredQueue( const vector<halfsegment> &
  * See the prototype in parPlaneSweep.h
  */
 void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, vector<halfsegment> &result, 
-							int numStrips, int numWorkerThreads )
+							int numStrips, int numWorkerThreads, OverlayStats *stats )
 {
 	vector<halfsegment> r1Strips, r2Strips;
 	vector< double > isoBounds;
@@ -166,15 +168,12 @@ void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, vector<h
 	result.clear();  // make sure the result vec is clear
 
 		// set default parallel values
-// ELEHMANN
 if ( numWorkerThreads > 0 ) {
-		tbb::task_scheduler_init init(tbb::task_scheduler_init::automatic);
 	}
 	else {
-		tbb::task_scheduler_init init(numWorkerThreads);
 	}
 	if (numStrips < 0) {
-		numStrips = tbb::task_scheduler_init::default_num_threads();
+		numStrips = 1;
 	}
 
 
@@ -189,39 +188,53 @@ if ( numWorkerThreads > 0 ) {
 	} 
 	
 	// find split points
+	std::chrono::time_point<std::chrono::system_clock> bounds_start = std::chrono::system_clock::now();
 	findIsoBoundaries( r1, r2, isoBounds );
+	std::chrono::duration<double> bounds_duration = std::chrono::system_clock::now() - bounds_start;
 
 	// split up the regions at the iso boundaries
-
-tbb::parallel_for(0, 2, [&] (int i) {
- 		if( i == 0 ) createStrips( r1, isoBounds, r1Strips, r1StripStopIndex );
-		else  createStrips( r2, isoBounds, r2Strips, r2StripStopIndex );}
-);
+// ELEHMANN
+	std::chrono::duration<double> strips_duration[2];
+	int track_regions[] = {0,1};
+	unsigned int r1Threads, r2Threads;
+	splitThreadBudget( numWorkerThreads, r1.size(), r2.size(), r1Threads, r2Threads );
+	std::for_each( std::execution::par, std::begin(track_regions), std::end(track_regions), [&] (int i){
+		std::chrono::time_point<std::chrono::system_clock> strips_start = std::chrono::system_clock::now();
+		if( i == 0 ) createStrips( r1Threads, r1, isoBounds, r1Strips, r1StripStopIndex );
+		else  createStrips( r2Threads, r2, isoBounds, r2Strips, r2StripStopIndex );
+		strips_duration[i] = std::chrono::system_clock::now() - strips_start;
+		});
 	std::chrono::time_point<std::chrono::system_clock> sweep_start = std::chrono::system_clock::now();
-	tbb::parallel_for(0, numStrips, [&](int i) {
+	std::vector<int> track_strips(numStrips);
+	std::iota( track_strips.begin(), track_strips.end(), 0);
+	std::for_each( std::execution::par, track_strips.begin(), track_strips.end(), [&] (int i) {
 	partialOverlay( r1Strips, r2Strips, resultStrips[i], r1StripStopIndex, r2StripStopIndex, i );
-	});
-	std::chrono::time_point<std::chrono::system_clock> sweep_end = std::chrono::system_clock::now();
-	// create the final overlay
-	std::chrono::time_point<std::chrono::system_clock> reconstruct_start = std::chrono::system_clock::now();
+		});
+	std::chrono::duration<double> sweep_duration = std::chrono::system_clock::now() - sweep_start;
+// END
+	std::chrono::time_point<std::chrono::system_clock> recombine_start = std::chrono::system_clock::now();
 	createFinalOverlay(  result,
 										 resultStrips, 
 												isoBounds );
-	std::chrono::time_point<std::chrono::system_clock> reconstruct_end = std::chrono::system_clock::now();
-	std::chrono::duration<double> sweep_duration = sweep_end - sweep_start;
-	std::chrono::duration<double> reconstruct_duration = reconstruct_end- reconstruct_start;
-	std::ofstream csv;
-	csv.open("frameworks.csv", std::ofstream::out | std::ofstream::app);
-	csv << "tbb," << sweep_duration.count() << "," << reconstruct_duration.count() <<"," << numStrips << std::endl;
-	csv.close();
-// END
+	std::chrono::duration<double> recombine_duration = std::chrono::system_clock::now() - recombine_start;
+
+	if( stats != NULL ) {
+		stats->implementation = "Loser Tree";
+		stats->findBoundsTime = bounds_duration.count();
+		stats->r1StripsTime = strips_duration[0].count();
+		stats->r2StripsTime = strips_duration[1].count();
+		stats->r1StripSegs = r1Strips.size();
+		stats->r2StripSegs = r2Strips.size();
+		stats->sweepTime = sweep_duration.count();
+		stats->recombineTime = recombine_duration.count();
+		stats->numStrips = numStrips;
+		stats->r1Segs = r1.size();
+		stats->r2Segs = r2.size();
+		stats->resultSegs = result.size();
+	}
+
 }
 
-// call the individual overlay functions.
-// this function just sets up the function calls to overlayPlaneSweep
-/**
- * See the prototype in parPlaneSweep.h
- */
 void partialOverlay( 	const vector<halfsegment> & r1Strips, const vector<halfsegment> & r2Strips,
 											vector<halfsegment> & result, 
 											vector< int > &r1StripStopIndex, vector< int > &r2StripStopIndex, 
@@ -674,70 +687,210 @@ bool hsegIDSort( const halfsegment & h1, const halfsegment & h2 )
 {
 		return h1.stripID < h2.stripID || (h1.stripID == h2.stripID && h1 < h2 );
 }
-
-void createStrips( vector< halfsegment> & region, vector<double> &isoBounds, 
-									 vector<halfsegment> & rStrips, 	vector< int > &stripStopIndex )
-{
+// ELEHMANN
+void threadedStrips(unsigned int threadnum, unsigned int threadcount, std::vector<halfsegment> *myVector, vector<halfsegment> &region, vector<double> &isoBounds,
+									vector<halfsegment> &rStrips, vector<int> *tempStop){
 	halfsegment workSeg;
 	int startBound = 0;
-	// grab a seg, break it on each strip that it crosses, put it in the strips
-	for( int i = 0; i< region.size(); i++ ) {
-		// only need to worry about lefties
-		if( region[i].isLeft( ) ) {
+	int threadMin = threadnum * (region.size()/threadcount);
+	int threadMax;
+	if (threadnum == threadcount -1){
+		threadMax = region.size();
+	}
+	else{
+		threadMax = threadMin + (region.size()/threadcount);
+	}
+	for ( int i = threadMin; i < threadMax; i++){
+		if (region[i].isLeft()){
 			workSeg = region[i];
-			for( int j = startBound; j < isoBounds.size()-1; j++ ){
-				if( workSeg.dx > isoBounds[j+1] ) {
-					// we are done with this strip (hseg ordering)
+			for (int j = startBound; j < isoBounds.size()-1; j++){
+				if (workSeg.dx > isoBounds[j+1]){
 					startBound++;
 					continue;
 				}
-				// check if we cross the boundary. 
-				// remember, we won't have any seg end on a boundary unless we split it
-				else if( workSeg.dx >= isoBounds[j] && workSeg.sx < isoBounds[j+1] ) {
+				else if (workSeg.dx >= isoBounds[j] && workSeg.sx < isoBounds[j+1]){
 					workSeg.stripID = j;
-					rStrips.push_back( workSeg );
-					rStrips.push_back( workSeg.getBrother( ) );
-					break; // done with this seg
+					myVector->push_back(workSeg);
+					myVector->push_back(workSeg.getBrother());
+					break;
 				}
-				// otherwise, we cross a boundary
-				else {
-					// get the y value at iso bound
+				else{
 					halfsegment lhs = workSeg;
-					// make the segs split at isoBounds[j]
-					lhs.sy = workSeg.dy = workSeg.getYvalAtX( isoBounds[j+1] );
+					lhs.sy = workSeg.dy = workSeg.getYvalAtX(isoBounds[j+1]);
 					lhs.sx = workSeg.dx = isoBounds[j+1];
 					lhs.stripID = j;
-					rStrips.push_back( lhs );
-					rStrips.push_back( lhs.getBrother() );
+					myVector->push_back(lhs);
+					myVector->push_back(lhs.getBrother());
 				}
 			}
 		}
 	}
-        // deallocate input segments (to save memory!)
-        // use the swap to local var trick!
-        //{
-          //  vector< halfsegment > localOne;
-           // region.swap(localOne);
-        //}
+	std::sort(myVector->begin(), myVector->end(), hsegIDSort);
 
-	// sort the strips by stripID, then by hseg order
-
-	std::sort( rStrips.begin(), rStrips.end(), hsegIDSort);
-	// find the startIndex for each strip
 	for( int i = 0; i < isoBounds.size()-1; i++ )
-		stripStopIndex.push_back( std::numeric_limits<int>::min() ); 
-	for( int i = 0; i < rStrips.size(); i++ ){
-		if( i >= stripStopIndex[ rStrips[i].stripID ] )
-			stripStopIndex[ rStrips[i].stripID ] = i+1;
+		tempStop->push_back( std::numeric_limits<int>::min() ); 
+	for( int i = 0; i < myVector->size(); i++ ){
+		if( i >= tempStop->at(myVector->at(i).stripID))
+			tempStop->at(myVector->at(i).stripID) = i+1;
 	}
 	// remove any remaining min vals
 	int prevVal = 0;
-	for( int i = 0; i <  stripStopIndex.size(); i++ ) {
-		if( stripStopIndex[i] == std::numeric_limits<int>::min()  ) {
-			stripStopIndex[i] = prevVal;
+	for( int i = 0; i <  tempStop->size(); i++ ) {
+		if( tempStop->at(i) == std::numeric_limits<int>::min()  ) {
+			tempStop->at(i) = prevVal;
 		}
-		prevVal = stripStopIndex[i];
+		prevVal = tempStop->at(i);
 	}
+}
+
+/**
+ * \class loserTree
+ *
+ * \brief A tournament (loser) tree over k sorted runs of halfsegments.
+ *
+ * Leaves are the heads of the runs. Each internal node stores the run that lost the
+ * match played at that node and node 0 stores the overall winner, which is the smallest
+ * head.  After the winner is popped only the matches on the path from its leaf to the 
+ * root are replayed, so every output element costs O(log k) comparisons instead of the
+ * O(k) scan over all runs.
+ *
+ * Exhausted runs act as +infinity, and ties go to the lower run index so the merge is
+ * stable.
+ */
+class loserTree
+{
+	private:
+		/// current head and end of each run
+		vector< vector<halfsegment>::iterator > cur, end;
+		/// tree[0] is the winner, tree[1..k-1] hold the losers of the internal matches
+		vector<int> tree;
+		int k;
+
+		/// true if the head of run a comes before the head of run b
+		inline bool beats( int a, int b ) const {
+			if( cur[a] == end[a] ) return false;
+			if( cur[b] == end[b] ) return true;
+			if( *cur[a] < *cur[b] ) return true;
+			if( *cur[b] < *cur[a] ) return false;
+			return a < b;
+		}
+
+	public:
+		loserTree( vector< vector<halfsegment>::iterator > &starts, vector< vector<halfsegment>::iterator > &ends )
+			: cur( starts ), end( ends ), tree( starts.size() ), k( starts.size() )
+		{
+			// play the initial tournament bottom up.  Leaf i sits at position k+i.
+			vector<int> winner( 2*k );
+			for( int i = 0; i < k; i++ ) {
+				winner[k+i] = i;
+			}
+			for( int node = k-1; node > 0; node-- ) {
+				int l = winner[2*node];
+				int r = winner[2*node+1];
+				bool lWins = beats( l, r );
+				winner[node] = lWins ? l : r;
+				tree[node] = lWins ? r : l;
+			}
+			tree[0] = winner[1];
+		}
+
+		/// true when every run has been consumed
+		bool empty( ) const {
+			return cur[ tree[0] ] == end[ tree[0] ];
+		}
+
+		/// copy the smallest head to out and advance that run
+		void pop( halfsegment &out ) {
+			int w = tree[0];
+			out = *cur[w]++;
+			// replay the matches on the path from the winner's leaf to the root
+			for( int node = (w+k)/2; node > 0; node /= 2 ) {
+				int challenger = tree[node];
+				bool swap = beats( challenger, w );
+				tree[node] = swap ? w : challenger;
+				w = swap ? challenger : w;
+			}
+			tree[0] = w;
+		}
+};
+
+/**
+ *  Merge the per-thread sorted vectors into rStrips using a loser tree.
+ *
+ *  Strips are handed out round robin, exactly as in tmerge().  For each strip the non-empty
+ *  per-thread runs are merged straight into the strip's final position in rStrips.
+ */
+void loserTreeMerge( int threadnum, int threadcount, int stripCount, std::vector<std::vector<halfsegment>*> 
+		&tempVectors, std::vector<std::vector<int>*> &tempStop, std::vector<halfsegment> &rStrips,
+		std::vector<int> &stripStopIndex )
+{
+	vector< vector<halfsegment>::iterator > starts, ends;
+	for( int workStrip = threadnum; workStrip < stripCount; workStrip += threadcount ) {
+		auto writehere = rStrips.begin();
+		if( workStrip != 0 ) {
+			writehere = rStrips.begin() + stripStopIndex[workStrip-1];
+		}
+		starts.clear();
+		ends.clear();
+		for( int i = 0; i < tempVectors.size(); i++ ) {
+			auto startSegment = tempVectors[i]->begin();
+			if( workStrip != 0 ) {
+				startSegment = tempVectors[i]->begin() + tempStop[i]->at(workStrip-1);
+			}
+			auto endSegment = tempVectors[i]->begin() + tempStop[i]->at(workStrip);
+			if( startSegment != endSegment ) {
+				starts.push_back( startSegment );
+				ends.push_back( endSegment );
+			}
+		}
+		if( starts.empty() ) {
+			continue;
+		}
+		loserTree lt( starts, ends );
+		while( !lt.empty() ) {
+			lt.pop( *writehere++ );
+		}
+	}
+}
+
+void createStrips( unsigned int rThreads,  vector< halfsegment> & region, vector<double> &isoBounds, 
+									 vector<halfsegment> & rStrips, 	vector< int > &stripStopIndex )
+{
+	unsigned int nthread = preprocessingThreadCount( rThreads, region.size() );
+	std::vector<std::vector<halfsegment>*> tempVectors;
+	std::vector<std::vector<int>*> tempStop;
+	for (unsigned int i = 0; i < nthread; i++){
+		tempVectors.push_back(new std::vector<halfsegment>);
+		tempStop.push_back(new std::vector<int>);
+	}
+	std::vector<int> track_threads;
+	for (unsigned int i = 0; i < nthread; i++){track_threads.push_back(i);}
+	std::for_each( std::execution::par, track_threads.begin(), track_threads.end(), [&] (int i) {
+		threadedStrips(i, nthread, tempVectors[i], region, isoBounds, rStrips, tempStop[i]);
+	});
+	int prev_value = 0;
+	for (unsigned int i = 0; i < isoBounds.size() - 1 ; i++){
+		int value = 0;
+		for (auto it = tempStop.begin(); it != tempStop.end(); it++){
+			if (i == 0){
+				value = value + (*it)->at(i);
+			}
+			else{
+				value = value + ((*it)->at(i)-(*it)->at(i-1));
+			}
+		}
+		prev_value = value + prev_value;
+		stripStopIndex.push_back(prev_value);
+	}
+	rStrips.resize(stripStopIndex.back());
+   std::for_each( std::execution::par_unseq, track_threads.begin(), track_threads.end(), [&] (int i) {
+		 loserTreeMerge( i, nthread, isoBounds.size() -1, tempVectors, tempStop, rStrips, stripStopIndex);
+	 });
+	for (unsigned int i = 0; i < nthread; i++){
+		delete tempVectors[i];
+		delete tempStop[i];
+	}
+
 	
 #ifdef DEBUG_PRINT
 #pragma omp critical
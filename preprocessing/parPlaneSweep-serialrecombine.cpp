@@ -89,12 +89,13 @@ void findIsoBoundaries( vector<halfsegment> &r1, vector<halfsegment> &r2,
 /**
  *  Break an input region up into strips.  Strip boundaries are isoBounds
  *
+ *  \param rThreads the thread budget for this region (see splitThreadBudget())
  *  \param region the region to split into strips
  *  \param isoBounds  the strip boundaries
  *  \param rStrips [out] the region broken into strips.  Each halfsegment will have a strip ID indicating the strip to which it belongs.  stripIDs start at 0 and increment.
  *  \param stripStopIndex [out] halfsegments in rStrips are sorted by strip ID then halfsegment ordering.  This vector marks the positions in the rStrips array where the last halfsegment in each strip is located.
  */
-void createStrips(unsigned int rThreadNum, vector< halfsegment> & region, vector<double> &isoBounds, 
+void createStrips(unsigned int rThreads, vector< halfsegment> & region, vector<double> &isoBounds, 
 									 vector<halfsegment> & rStrips, 	vector< int > &stripStopIndex );
 
 
@@ -157,7 +158,7 @@ void insertBrokenSegsToActiveListAndDiscoveredQueue( const vector<halfsegment> &
  * See the prototype in parPlaneSweep.h
  */
 void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, vector<halfsegment> &result, 
-							int numStrips, int numWorkerThreads )
+							int numStrips, int numWorkerThreads, OverlayStats *stats )
 {
 	vector<halfsegment> r1Strips, r2Strips;
 	vector< double > isoBounds;
@@ -186,27 +187,51 @@ if ( numWorkerThreads > 0 ) {
 	} 
 	
 	// find split points
+	std::chrono::time_point<std::chrono::system_clock> bounds_start = std::chrono::system_clock::now();
 	findIsoBoundaries( r1, r2, isoBounds );
+	std::chrono::duration<double> bounds_duration = std::chrono::system_clock::now() - bounds_start;
 
 	// split up the regions at the iso boundaries
 // ELEHMANN
+	std::chrono::duration<double> strips_duration[2];
 	int track_regions[] = {0,1};
-	unsigned int thread0 = 0;
-	unsigned int thread1 = 1;
+	unsigned int r1Threads, r2Threads;
+	splitThreadBudget( numWorkerThreads, r1.size(), r2.size(), r1Threads, r2Threads );
 	std::for_each( std::execution::par, std::begin(track_regions), std::end(track_regions), [&] (int i){
-		if( i == 0 ) createStrips(thread0, r1, isoBounds, r1Strips, r1StripStopIndex );
-		else  createStrips( thread1, r2, isoBounds, r2Strips, r2StripStopIndex );
+		std::chrono::time_point<std::chrono::system_clock> strips_start = std::chrono::system_clock::now();
+		if( i == 0 ) createStrips( r1Threads, r1, isoBounds, r1Strips, r1StripStopIndex );
+		else  createStrips( r2Threads, r2, isoBounds, r2Strips, r2StripStopIndex );
+		strips_duration[i] = std::chrono::system_clock::now() - strips_start;
 		});
+	std::chrono::time_point<std::chrono::system_clock> sweep_start = std::chrono::system_clock::now();
 	std::vector<int> track_strips(numStrips);
 	std::iota( track_strips.begin(), track_strips.end(), 0);
 	std::for_each( std::execution::par, track_strips.begin(), track_strips.end(), [&] (int i) {
 	partialOverlay( r1Strips, r2Strips, resultStrips[i], r1StripStopIndex, r2StripStopIndex, i );
 		});
+	std::chrono::duration<double> sweep_duration = std::chrono::system_clock::now() - sweep_start;
 //END
 
+	std::chrono::time_point<std::chrono::system_clock> recombine_start = std::chrono::system_clock::now();
 	createFinalOverlay(  result,
 										 resultStrips, 
 												isoBounds );
+	std::chrono::duration<double> recombine_duration = std::chrono::system_clock::now() - recombine_start;
+
+	if( stats != NULL ) {
+		stats->implementation = "Serial Vector";
+		stats->findBoundsTime = bounds_duration.count();
+		stats->r1StripsTime = strips_duration[0].count();
+		stats->r2StripsTime = strips_duration[1].count();
+		stats->r1StripSegs = r1Strips.size();
+		stats->r2StripSegs = r2Strips.size();
+		stats->sweepTime = sweep_duration.count();
+		stats->recombineTime = recombine_duration.count();
+		stats->numStrips = numStrips;
+		stats->r1Segs = r1.size();
+		stats->r2Segs = r2.size();
+		stats->resultSegs = result.size();
+	}
 
 }
 
@@ -708,11 +733,10 @@ void threadedStrips(unsigned int threadnum, unsigned int threadcount, std::vecto
 	}
 
 }
-void createStrips( unsigned int rThreadNum,  vector< halfsegment> & region, vector<double> &isoBounds, 
+void createStrips( unsigned int rThreads,  vector< halfsegment> & region, vector<double> &isoBounds, 
 									 vector<halfsegment> & rStrips, 	vector< int > &stripStopIndex )
 {
-	std::chrono::time_point<std::chrono::system_clock> preprocess_start = std::chrono::system_clock::now();
-	unsigned int nthread = std::thread::hardware_concurrency() / 2;
+	unsigned int nthread = preprocessingThreadCount( rThreads, region.size() );
 	std::vector<std::vector<halfsegment>*> tempVectors;
 	for (unsigned int i = 0; i < nthread; i++){
 			tempVectors.push_back(new std::vector<halfsegment>);
@@ -755,12 +779,6 @@ void createStrips( unsigned int rThreadNum,  vector< halfsegment> & region, vect
 		prevVal = stripStopIndex[i];
 	}
 	
-	std::chrono::time_point<std::chrono::system_clock> preprocess_end = std::chrono::system_clock::now();
-	std::chrono::duration<double> preprocess_duration = preprocess_end - preprocess_start;
-	std::ofstream csv;
-	csv.open("preprocessing.csv", std::ofstream::out | std::ofstream::app);
-	csv << "Serial Vector," << isoBounds.size() - 1 << "," << preprocess_duration.count() << std::endl;
-	csv.close();
 #ifdef DEBUG_PRINT
 #pragma omp critical
 	{
@@ -15,6 +15,8 @@
 #include <chrono>
 #include <iostream>
 #include <fstream>
+#include <thread>
+#include <cstdlib>
 
 #ifndef PARSESWEEP_H
 #define PARSESWEEP_H
@@ -33,6 +35,33 @@ using namespace std;
 
 //#define DEBUG_PRINT
 
+/**
+ * \struct OverlayStats
+ *
+ * \brief wall times (in seconds) and sizes of one parallelOverlay() call.
+ *
+ *  Pass one to parallelOverlay() to have it filled in.  Nothing is written to disk by the 
+ *  library, main.cpp writes the stats as csv or json.
+ */
+struct OverlayStats {
+	string implementation;   ///< the strip creation algorithm, the first column of preprocessing.csv
+	double findBoundsTime;   ///< placing the iso bounds
+	double r1StripsTime;     ///< splitting region 1 into strips.  Runs next to r2StripsTime
+	double r2StripsTime;     ///< splitting region 2 into strips.  -1 if both regions are split in one pass, timed by r1StripsTime
+	double sweepTime;        ///< sweeping all strips
+	double recombineTime;    ///< joining the strips into the final result
+	int numStrips;           ///< strips swept
+	long long r1Segs;        ///< input halfsegments in region 1
+	long long r2Segs;        ///< input halfsegments in region 2
+	long long r1StripSegs;   ///< halfsegments of region 1 after splitting them at the iso bounds
+	long long r2StripSegs;   ///< halfsegments of region 2 after splitting them at the iso bounds
+	long long resultSegs;    ///< halfsegments in the result
+
+	OverlayStats( ) : findBoundsTime( 0 ), r1StripsTime( 0 ), r2StripsTime( 0 ), sweepTime( 0 ),
+										recombineTime( 0 ), numStrips( 0 ), r1Segs( 0 ), r2Segs( 0 ), 
+										r1StripSegs( 0 ), r2StripSegs( 0 ), resultSegs( 0 ) { }
+};
+
 
 
 
@@ -44,10 +73,11 @@ using namespace std;
  *  \param r1 [in/out] input region 1
  *  \param r2 [in/out] input region 2
  *  \param numSplits how many strips should be created over the input. If no value is given, the number of strips defaults to the number of processor cores.
- * \param numWorkerThreads The number of worker threads for openMP to use.  If no value is given, openMP's default value is used.
+ * \param numWorkerThreads The number of worker threads to use.  If no value is given, the framework's default value is used.  Threaded strip creation splits this budget between r1 and r2 (see splitThreadBudget()).
+ * \param stats [out] if not NULL, filled in with the timings and sizes of the overlay
  */
 void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, vector<halfsegment> &result, 
-											int numSplits=-1,  int numWorkerThreads = -1);
+											int numSplits=-1,  int numWorkerThreads = -1, OverlayStats *stats = NULL );
 
 
 
@@ -65,6 +95,80 @@ void parallelOverlay( vector<halfsegment> &r1, vector<halfsegment> &r2, vector<h
 void overlayPlaneSweep( const halfsegment r1[], int r1Size, 
 												const halfsegment r2[], int r2Size, 
 												vector<halfsegment>& result );
+
+/**
+ *  Default for the smallest number of halfsegments worth handing to a strip building thread,
+ *  used unless PPS_PREPROCESS_MIN_SEGS is set.
+ *
+ *  Not measured: the threshold.csv in the tree was taken on a single cpu and shows no point at 
+ *  which more threads win.  Run threshold.sh on the target multi-core machine, which prints 
+ *  the measured value to set PPS_PREPROCESS_MIN_SEGS to (and to put here).
+ */
+const unsigned int PREPROCESS_DEFAULT_MIN_SEGS_PER_THREAD = 4096;
+
+/**
+ *  The smallest number of halfsegments worth handing to a strip building thread: the 
+ *  PPS_PREPROCESS_MIN_SEGS environment variable if it is set, otherwise 
+ *  PREPROCESS_DEFAULT_MIN_SEGS_PER_THREAD.  Always at least 1.
+ */
+inline unsigned int preprocessingMinSegsPerThread( )
+{
+	const char *env = getenv( "PPS_PREPROCESS_MIN_SEGS" );
+	if( env != NULL && atoi( env ) > 0 ) {
+		return atoi( env );
+	}
+	return PREPROCESS_DEFAULT_MIN_SEGS_PER_THREAD;
+}
+
+/**
+ *  Split the caller's thread budget between the two input regions in proportion to their sizes.
+ *
+ *  \param numWorkerThreads the parallelOverlay() thread budget.  Values < 1 use all hardware threads.
+ *  \param r1Threads [out] threads for region 1, at least 1
+ *  \param r2Threads [out] threads for region 2, at least 1
+ */
+inline void splitThreadBudget( int numWorkerThreads, size_t r1Size, size_t r2Size, 
+															 unsigned int &r1Threads, unsigned int &r2Threads )
+{
+	unsigned int budget = numWorkerThreads;
+	if( numWorkerThreads < 1 ) {
+		budget = std::thread::hardware_concurrency();
+	}
+	if( budget < 2 || r1Size+r2Size == 0 ) {
+		r1Threads = r2Threads = 1;
+		return;
+	}
+	r1Threads = (unsigned int)( (double)budget * r1Size / (r1Size+r2Size) + 0.5 );
+	if( r1Threads < 1 ) r1Threads = 1;
+	if( r1Threads > budget-1 ) r1Threads = budget-1;
+	r2Threads = budget - r1Threads;
+}
+
+/**
+ *  The number of threads a threaded createStrips() implementation uses for one region.
+ *
+ *  Uses the region's share of the thread budget, but never gives a thread fewer than
+ *  preprocessingMinSegsPerThread() halfsegments, so small regions are split into strips
+ *  serially.  Setting the PPS_PREPROCESS_THREADS environment variable overrides all of 
+ *  this, so the preprocessing implementations can be compared at fixed thread counts.
+ *  Always returns at least 1.
+ */
+inline unsigned int preprocessingThreadCount( unsigned int rThreads, size_t regionSize )
+{
+	const char *env = getenv( "PPS_PREPROCESS_THREADS" );
+	if( env != NULL && atoi( env ) > 0 ) {
+		return atoi( env );
+	}
+	unsigned int nthread = rThreads;
+	unsigned int minSegs = preprocessingMinSegsPerThread();
+	if( regionSize / minSegs < nthread ) {
+		nthread = regionSize / minSegs;
+	}
+	if( nthread == 0 ) {
+		nthread = 1;
+	}
+	return nthread;
+}
 #endif
 
 
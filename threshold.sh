@@ -0,0 +1,84 @@
+#!/bin/bash
+# Measure where splitting a region across preprocessing threads starts to pay off, the 
+# PREPROCESS_DEFAULT_MIN_SEGS_PER_THREAD threshold in preprocessing/parPlaneSweep.h.
+# Each implementation splits generated regions of growing size into strips at fixed thread 
+# counts.  The mean strip creation time of one region goes to threshold.csv as
+# implementation,halfsegments,threads,seconds
+# and the smallest halfsegments per thread at which more threads beat one thread by at least 
+# 10%, more than the run to run noise, is printed.  The largest of those is the measured 
+# threshold, printed as a PPS_PREPROCESS_MIN_SEGS setting.  Thread counts above the number of cpus can 
+# not run in parallel and are left out of it, so a single cpu machine measures no threshold.
+PROJ_DIR=$(pwd)/preprocessing
+IMPLEMENTATION="serialrecombine tmerge losertree mergepath"
+SIZES="1000 4000 16000 64000"
+THREADS="1 2 4 8"
+STRIPS=64
+RUNS=10
+export LD_LIBRARY_PATH=$PROJ_DIR
+make -C generator && make -C preprocessing || exit 1
+mkdir -p data threshold-runs
+echo "implementation,halfsegments,threads,seconds" > threshold.csv
+for N in $SIZES
+do
+	if [ ! -f data/threshold-${N}1.hex ]; then
+		generator/regionGen $N data/threshold-${N}1.hex data/threshold-${N}2.hex
+	fi
+	# every line of a hex file holds one segment, which is two halfsegments, so the lines of
+	# both files are the halfsegments of an average region
+	HSEGS=$(cat data/threshold-${N}1.hex data/threshold-${N}2.hex | wc -l)
+	for T in $THREADS
+	do
+		export PPS_PREPROCESS_THREADS=$T
+		for IMPL in $IMPLEMENTATION
+		do
+			echo "Segments $N threads $T $IMPL"
+			rm -f threshold-runs/preprocessing.csv
+			for i in $(seq $RUNS)
+			do
+				(cd threshold-runs && "$PROJ_DIR"/"$IMPL" ../data/threshold-${N}1.hex ../data/threshold-${N}2.hex "$STRIPS" "$STRIPS" > /dev/null 2>&1)
+			done
+			# one line per region and run
+			awk -F, -v impl=$IMPL -v hsegs=$HSEGS -v t=$T '{ sum += $3; n++ } 
+				END { printf "%s,%d,%d,%g\n", impl, hsegs, t, sum/n }' threshold-runs/preprocessing.csv >> threshold.csv
+		done
+	done
+done
+rm -rf threshold-runs
+awk -F, -v cpus=$(nproc) 'NR > 1 { 
+		key = $1 "," $2
+		if( $3 == 1 ) serial[ key ] = $4
+		time[ key "," $3 ] = $4
+		if( !( $1 in seen ) ) { seen[ $1 ] = 1; impls[ ++numImpls ] = $1 }
+		if( !( $2 in seenSize ) ) { seenSize[ $2 ] = 1; sizes[ ++numSizes ] = $2 }
+		if( !( $3 in seenThreads ) ) { seenThreads[ $3 ] = 1; threads[ ++numThreads ] = $3 }
+	}
+	END {
+		threshold = 0
+		for( i = 1; i <= numImpls; i++ ) {
+			for( k = 2; k <= numThreads; k++ ) {
+				t = threads[k]
+				if( t > cpus ) {
+					printf "%s, %d threads: more threads than the %d cpus, left out\n", impls[i], t, cpus
+					continue
+				}
+				found = 0
+				for( s = 1; s <= numSizes && found == 0; s++ ) {
+					key = impls[i] "," sizes[s]
+					if( time[ key "," t ] < 0.9 * serial[ key ] ) found = int( sizes[s] / t )
+				}
+				if( found == 0 ) {
+					printf "%s, %d threads beat 1 thread by 10%% from: never\n", impls[i], t
+				}
+				else {
+					printf "%s, %d threads beat 1 thread by 10%% from: %d halfsegments per thread\n", impls[i], t, found
+					if( found > threshold ) threshold = found
+				}
+			}
+		}
+		if( threshold == 0 ) {
+			print "more threads never won, no threshold measured"
+		}
+		else {
+			printf "measured threshold: export PPS_PREPROCESS_MIN_SEGS=%d\n", threshold
+		}
+	}' threshold.csv